@@ -0,0 +1,239 @@
+#include "batchprocessor.h"
+#include "imagedecoder.h"
+#include "taskscheduler.h"
+#include "ziparchive.h"
+#include <QCommandLineParser>
+#include <QDir>
+#include <QFileInfo>
+#include <QGuiApplication>
+#include <QImageWriter>
+#include <QPainter>
+#include <QSet>
+#include <QTextStream>
+#include <cstring>
+
+namespace {
+    constexpr int DEFAULT_THUMBNAIL_SIZE = 256;
+
+    QStringList expandInputs(const QStringList &arguments)
+    {
+        QStringList files;
+        for (const QString &argument : arguments) {
+            QFileInfo info(argument);
+            if (info.isDir()) {
+                QDir dir(info.absoluteFilePath());
+                dir.setNameFilters(ImageDecoder::nameFilters());
+                const QFileInfoList entries = dir.entryInfoList(QDir::Files | QDir::NoDotAndDotDot, QDir::Name);
+                for (const QFileInfo &entry : entries) {
+                    files << entry.absoluteFilePath();
+                }
+            } else if (ZipArchive::isArchiveFile(argument) && info.isFile()) {
+                files << ZipArchive::imagePaths(info.absoluteFilePath());
+            } else {
+                files << info.absoluteFilePath();
+            }
+        }
+        return files;
+    }
+}
+
+bool BatchProcessor::isBatchInvocation(int argc, char *argv[])
+{
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--batch-thumbnail") == 0 || std::strcmp(argv[i], "--convert") == 0
+            || std::strncmp(argv[i], "--convert=", 10) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int BatchProcessor::run(int argc, char *argv[])
+{
+    // Servers have no display; QPainter/SVG only need a GUI application, not a screen
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QGuiApplication app(argc, argv);
+    app.setApplicationName("Image Viewer");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("MyView batch mode");
+    parser.addHelpOption();
+    QCommandLineOption thumbnailOption("batch-thumbnail", "Write thumbnails.");
+    QCommandLineOption convertOption("convert", "Convert to <format> (png, jpg, webp, ...).", "format");
+    QCommandLineOption sizeOption("size", "Fit into <px> x <px>. Thumbnails default to 256.", "px");
+    QCommandLineOption outputOption("output", "Output folder.", "dir");
+    QCommandLineOption formatOption("format", "Thumbnail format, default jpg.", "format", "jpg");
+    QCommandLineOption qualityOption("quality", "Encoder quality 0-100.", "q");
+    QCommandLineOption jobsOption("jobs", "Images processed at once, default one per core.", "n");
+    parser.addOptions({thumbnailOption, convertOption, sizeOption, outputOption, formatOption, qualityOption, jobsOption});
+    parser.addPositionalArgument("inputs", "Image files or folders.", "FILES/DIRS...");
+    parser.process(app);
+
+    Options options;
+    options.mode = parser.isSet(convertOption) ? Convert : Thumbnail;
+    options.format = (options.mode == Convert ? parser.value(convertOption) : parser.value(formatOption)).toLower().toLatin1();
+    options.quality = parser.isSet(qualityOption) ? parser.value(qualityOption).toInt() : -1;
+    options.jobs = parser.value(jobsOption).toInt();
+    options.outputDir = parser.isSet(outputOption)
+        ? parser.value(outputOption)
+        : QString(options.mode == Convert ? "converted" : "thumbnails");
+
+    int size = parser.isSet(sizeOption) ? parser.value(sizeOption).toInt()
+                                        : (options.mode == Thumbnail ? DEFAULT_THUMBNAIL_SIZE : 0);
+    if (size > 0) options.bound = QSize(size, size);
+
+    QTextStream err(stderr);
+    if (!QImageWriter::supportedImageFormats().contains(options.format)) {
+        err << "Unsupported output format: " << options.format << Qt::endl;
+        return 2;
+    }
+
+    options.inputs = expandInputs(parser.positionalArguments());
+    if (options.inputs.isEmpty()) {
+        err << "No input images." << Qt::endl;
+        parser.showHelp(2);
+    }
+    if (!QDir().mkpath(options.outputDir)) {
+        err << "Cannot create output folder: " << options.outputDir << Qt::endl;
+        return 2;
+    }
+
+    BatchProcessor processor(options);
+    QObject::connect(&processor, &BatchProcessor::finished, &app, [&app](int exitCode) {
+        app.exit(exitCode);
+    });
+    processor.start();
+    return app.exec();
+}
+
+BatchProcessor::BatchProcessor(const Options &options, QObject *parent)
+    : QObject(parent)
+    , m_options(options)
+    , m_outputs(outputPaths(options))
+    , m_next(0)
+    , m_inFlight(0)
+    , m_done(0)
+    , m_failed(0)
+{
+    if (m_options.jobs <= 0) {
+        m_options.jobs = TaskScheduler::instance()->counters().workers;
+    }
+}
+
+void BatchProcessor::start()
+{
+    if (m_options.inputs.isEmpty()) {
+        QMetaObject::invokeMethod(this, [this]() { emit finished(0); }, Qt::QueuedConnection);
+        return;
+    }
+    while (m_inFlight < m_options.jobs && m_next < m_options.inputs.size()) {
+        submitNext();
+    }
+}
+
+QStringList BatchProcessor::outputPaths(const Options &options)
+{
+    // d1/IMG_0001.jpg and d2/IMG_0001.jpg, or a.jpg and a.png, would share one
+    // output and race on it from two workers. Later ones get "-2", "-3", ...
+    // Names are compared case-folded, for case insensitive file systems.
+    const QDir outputDir(options.outputDir);
+    const QString suffix = "." + QString::fromLatin1(options.format);
+    QSet<QString> taken;
+    QStringList outputs;
+    outputs.reserve(options.inputs.size());
+    for (const QString &input : options.inputs) {
+        const QString base = QFileInfo(input).completeBaseName();
+        QString name = base + suffix;
+        for (int n = 2; taken.contains(name.toLower()); ++n) {
+            name = QString("%1-%2%3").arg(base).arg(n).arg(suffix);
+        }
+        taken.insert(name.toLower());
+        outputs << outputDir.filePath(name);
+    }
+    return outputs;
+}
+
+void BatchProcessor::submitNext()
+{
+    const QString input = m_options.inputs.at(m_next);
+    const QString output = m_outputs.at(m_next);
+    m_next++;
+    const Options options = m_options;
+    m_inFlight++;
+
+    // Nothing is on screen, so batch work takes the visible class and every worker.
+    // Only the read counts against the device limit, see process().
+    TaskScheduler::instance()->submit<Result>(TaskScheduler::Visible, ZipArchive::physicalPath(input), this,
+        [options, input, output](const TaskContext &ctx) { return process(ctx, options, input, output); },
+        [this](const Result &result) { onItemDone(result); });
+}
+
+BatchProcessor::Result BatchProcessor::process(const TaskContext &ctx, const Options &options,
+                                              const QString &input, const QString &output)
+{
+    Result result;
+    result.input = input;
+    result.output = output;
+
+    // The device slot covers the read; decode, resample and encode run on every worker
+    bool ok = false;
+    const QByteArray data = ImageDecoder::readSource(input, &ok);
+    ctx.releaseIo();
+    if (!ok) {
+        result.error = "cannot read image";
+        return result;
+    }
+
+    DecodedImage::Error error = DecodedImage::NoError;
+    QImage image = ImageDecoder::decodeToFit(input, data, options.bound, &error);
+    if (error == DecodedImage::CannotRead) {
+        result.error = "cannot read image";
+        return result;
+    }
+    if (image.isNull()) {
+        result.error = "image data corrupted";
+        return result;
+    }
+
+    // JPEG has no alpha, flatten onto white rather than black
+    if (image.hasAlphaChannel() && (options.format == "jpg" || options.format == "jpeg")) {
+        QImage flat(image.size(), QImage::Format_RGB32);
+        flat.fill(Qt::white);
+        QPainter painter(&flat);
+        painter.drawImage(0, 0, image);
+        painter.end();
+        image = flat;
+    }
+
+    QImageWriter writer(output, options.format);
+    if (options.quality >= 0) writer.setQuality(options.quality);
+    if (!writer.write(image)) {
+        result.error = writer.errorString();
+    }
+    return result;
+}
+
+void BatchProcessor::onItemDone(const Result &result)
+{
+    m_inFlight--;
+    m_done++;
+
+    QTextStream out(stdout);
+    if (result.error.isEmpty()) {
+        out << "[" << m_done << "/" << m_options.inputs.size() << "] "
+            << result.input << " -> " << result.output << Qt::endl;
+    } else {
+        m_failed++;
+        QTextStream err(stderr);
+        err << "[" << m_done << "/" << m_options.inputs.size() << "] "
+            << result.input << ": " << result.error << Qt::endl;
+    }
+
+    if (m_next < m_options.inputs.size()) {
+        submitNext();
+    } else if (m_inFlight == 0) {
+        emit finished(m_failed > 0 ? 1 : 0);
+    }
+}
@@ -0,0 +1,68 @@
+#ifndef BATCHPROCESSOR_H
+#define BATCHPROCESSOR_H
+
+#include <QObject>
+#include <QSize>
+#include <QStringList>
+
+class TaskContext;
+
+// Headless thumbnail generation / format conversion:
+//   myview --batch-thumbnail [--size N] [--output DIR] [--format EXT] [--jobs N] FILES/DIRS...
+//   myview --convert EXT [--size N] [--output DIR] [--jobs N] FILES/DIRS...
+// Uses the viewer's decoder on the shared TaskScheduler. At most --jobs
+// images are in flight, so memory stays bounded however long the list is.
+// Progress is streamed to stdout one line per file, errors go to stderr.
+class BatchProcessor : public QObject
+{
+    Q_OBJECT
+public:
+    enum Mode {
+        Thumbnail,
+        Convert
+    };
+
+    struct Options {
+        Mode mode = Thumbnail;
+        QSize bound;          // Invalid: keep original size
+        QString outputDir;
+        QByteArray format;
+        int quality = -1;
+        int jobs = 0;         // 0: one per worker
+        QStringList inputs;   // Files, expanded from folders
+    };
+
+    struct Result {
+        QString input;
+        QString output;
+        QString error;
+    };
+
+    static bool isBatchInvocation(int argc, char *argv[]);
+    // Creates its own (windowless) application object and runs to completion
+    static int run(int argc, char *argv[]);
+
+    explicit BatchProcessor(const Options &options, QObject *parent = nullptr);
+
+    // One output per input, in the same order; inputs sharing a base name get numbered
+    static QStringList outputPaths(const Options &options);
+
+    void start();
+
+signals:
+    void finished(int exitCode);
+
+private:
+    static Result process(const TaskContext &ctx, const Options &options, const QString &input, const QString &output);
+    void submitNext();
+    void onItemDone(const Result &result);
+
+    Options m_options;
+    QStringList m_outputs;
+    int m_next;
+    int m_inFlight;
+    int m_done;
+    int m_failed;
+};
+
+#endif // BATCHPROCESSOR_H
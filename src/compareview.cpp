@@ -0,0 +1,455 @@
+#include "compareview.h"
+#include "imagecache.h"
+#include "imagecanvas.h"
+#include "vectorrenderer.h"
+#include "zoommath.h"
+#include <QFileInfo>
+#include <QGridLayout>
+#include <QKeyEvent>
+#include <QLabel>
+#include <QMouseEvent>
+#include <QPainter>
+#include <QWheelEvent>
+
+namespace {
+    // Burst members decoded ahead of the active pane, one behind for stepping back
+    constexpr int PREFETCH_AHEAD = 3;
+    constexpr int PREFETCH_BEHIND = 1;
+    // Frame around each pane, drawn in the accent color on the active one
+    constexpr int FRAME_WIDTH = 2;
+
+    // Canvas offset on one axis: centered while it fits, else keeps `center`
+    // in the middle without uncovering the background
+    int placeAxis(double canvasLength, int viewportLength, double center)
+    {
+        if (canvasLength <= viewportLength) return qRound((viewportLength - canvasLength) / 2.0);
+        double pos = viewportLength / 2.0 - center * canvasLength;
+        return qRound(qBound(viewportLength - canvasLength, pos, 0.0));
+    }
+}
+
+ComparePane::ComparePane(QWidget *parent)
+    : QWidget(parent)
+    , m_viewport(new QWidget(this))
+    , m_canvas(new ImageCanvas(m_viewport))
+    , m_label(new QLabel(this))
+    , m_zoom(1.0)
+    , m_center(0.5, 0.5)
+    , m_active(false)
+{
+    m_canvas->setBackground(ImageCanvas::checkerboard());
+    QPalette pal = m_viewport->palette();
+    pal.setBrush(QPalette::Window, ImageCanvas::checkerboard());
+    m_viewport->setPalette(pal);
+    m_viewport->setBackgroundRole(QPalette::Window);
+    m_viewport->setAutoFillBackground(true);
+    m_viewport->setCursor(Qt::OpenHandCursor);
+
+    // Input is handled by the compare view on the viewport
+    m_canvas->setAttribute(Qt::WA_TransparentForMouseEvents);
+
+    m_label->setAttribute(Qt::WA_TransparentForMouseEvents);
+    m_label->setStyleSheet("QLabel { background-color: rgba(0, 0, 0, 150); color: white; padding: 2px 8px; border-radius: 4px; }");
+    m_label->hide();
+}
+
+void ComparePane::setImage(const QString &path, const ImagePyramid &pyramid)
+{
+    m_path = path;
+    m_pyramid = pyramid;
+    m_canvas->setImage(m_pyramid);
+    m_label->setText(QFileInfo(path).fileName());
+    m_label->adjustSize();
+    m_label->show();
+    placeCanvas();
+}
+
+void ComparePane::setMessage(const QString &path, const QString &message)
+{
+    m_path = path;
+    m_pyramid = ImagePyramid();
+    m_canvas->setMessage(message);
+    m_label->hide();
+    placeCanvas();
+}
+
+QString ComparePane::path() const
+{
+    return m_path;
+}
+
+bool ComparePane::hasImage() const
+{
+    return !m_pyramid.isNull();
+}
+
+QSize ComparePane::imageSize() const
+{
+    return m_pyramid.size();
+}
+
+QWidget *ComparePane::viewport() const
+{
+    return m_viewport;
+}
+
+void ComparePane::setView(double zoom, const QPointF &center)
+{
+    m_zoom = zoom;
+    m_center = center;
+    placeCanvas();
+}
+
+QSizeF ComparePane::canvasSizeFor(double zoom) const
+{
+    if (m_pyramid.isNull() || m_viewport->size().isEmpty()) return QSizeF(m_viewport->size());
+
+    // Same geometry as a tab: scaled from the source so 1:1 is exact on both axes
+    QSize fitSize = m_pyramid.size().scaled(m_viewport->size(), Qt::KeepAspectRatio);
+    double scale = zoom * fitSize.width() / m_pyramid.size().width();
+    return QSizeF(m_pyramid.size()) * scale;
+}
+
+QPointF ComparePane::imageFractionAt(const QPoint &pos) const
+{
+    QSizeF size = m_canvas->size();
+    if (size.isEmpty()) return QPointF(0.5, 0.5);
+    QPointF local = QPointF(pos - m_canvas->pos());
+    return QPointF(qBound(0.0, local.x() / size.width(), 1.0), qBound(0.0, local.y() / size.height(), 1.0));
+}
+
+double ComparePane::actualSizeFactor() const
+{
+    if (m_pyramid.isNull() || m_viewport->size().isEmpty()) return 1.0;
+
+    QSize fitSize = m_pyramid.size().scaled(m_viewport->size(), Qt::KeepAspectRatio);
+    if (fitSize.width() <= 0) return 1.0;
+    return double(m_pyramid.size().width()) / fitSize.width();
+}
+
+void ComparePane::setActive(bool active)
+{
+    if (m_active == active) return;
+    m_active = active;
+    update(); // Frame only, the viewport covers the rest
+}
+
+void ComparePane::resizeEvent(QResizeEvent *event)
+{
+    QWidget::resizeEvent(event);
+    m_viewport->setGeometry(rect().adjusted(FRAME_WIDTH, FRAME_WIDTH, -FRAME_WIDTH, -FRAME_WIDTH));
+    m_label->move(FRAME_WIDTH + 8, FRAME_WIDTH + 8);
+    placeCanvas();
+}
+
+void ComparePane::paintEvent(QPaintEvent *)
+{
+    QPainter painter(this);
+    painter.fillRect(rect(), m_active ? QColor(74, 144, 226) : QColor(43, 43, 43));
+}
+
+void ComparePane::placeCanvas()
+{
+    if (m_pyramid.isNull()) {
+        m_canvas->setGeometry(m_viewport->rect());
+        return;
+    }
+    QSizeF size = canvasSizeFor(m_zoom);
+    QSize viewportSize = m_viewport->size();
+    // One setGeometry per pane: moves and resizes land in the same repaint
+    m_canvas->setGeometry(placeAxis(size.width(), viewportSize.width(), m_center.x()),
+                          placeAxis(size.height(), viewportSize.height(), m_center.y()),
+                          qRound(size.width()), qRound(size.height()));
+}
+
+CompareView::CompareView(const QStringList &images, const QList<int> &shown, QWidget *parent)
+    : QWidget(parent)
+    , m_images(images)
+    , m_activePane(0)
+    , m_zoom(1.0)
+    , m_center(0.5, 0.5)
+    , m_dragging(false)
+{
+    setFocusPolicy(Qt::StrongFocus);
+
+    const int count = qBound(MIN_PANES, int(shown.size()), MAX_PANES);
+    // Side by side up to three, four as a 2x2 grid
+    const int columns = count == 4 ? 2 : count;
+
+    QGridLayout *layout = new QGridLayout(this);
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->setSpacing(0);
+    for (int i = 0; i < count; ++i) {
+        ComparePane *pane = new ComparePane(this);
+        pane->viewport()->installEventFilter(this);
+        layout->addWidget(pane, i / columns, i % columns);
+        m_panes << pane;
+        m_indexes << -1;
+    }
+
+    for (int i = 0; i < count && i < shown.size(); ++i) {
+        load(i, shown.at(i));
+    }
+    setActivePane(0);
+}
+
+CompareView::~CompareView()
+{
+    for (ComparePane *pane : std::as_const(m_panes)) {
+        if (!pane->pendingPath.isEmpty()) ImageCache::instance()->release(pane->pendingPath, pane);
+    }
+    for (const QString &path : std::as_const(m_prefetchPaths)) {
+        ImageCache::instance()->cancelPrefetch(path);
+    }
+}
+
+TaskScheduler::Priority CompareView::currentPriority(TaskScheduler::Priority whenVisible) const
+{
+    return isVisible() ? whenVisible : TaskScheduler::HiddenTab;
+}
+
+void CompareView::load(int pane, int index)
+{
+    if (index < 0 || index >= m_images.size()) return;
+
+    ComparePane *target = m_panes.at(pane);
+    const QString path = m_images.at(index);
+    if (!target->pendingPath.isEmpty()) {
+        ImageCache::instance()->release(target->pendingPath, target);
+        target->pendingPath.clear();
+    }
+    m_indexes[pane] = index;
+
+    // The pane is the receiver, so each one can drop its own request. A decoded
+    // image already held by another pane or tab calls back right away.
+    target->pendingPath = path;
+    ImageCache::instance()->request(path, currentPriority(TaskScheduler::Visible), target,
+        [this, pane](const DecodedImage &image) { showDecoded(pane, image); });
+}
+
+void CompareView::showDecoded(int pane, const DecodedImage &image)
+{
+    ComparePane *target = m_panes.at(pane);
+    target->pendingPath.clear();
+
+    if (image.error == DecodedImage::CannotRead) {
+        target->setMessage(image.path, "Error: Cannot load image.\n" + image.path);
+    } else if (!image.isValid()) {
+        target->setMessage(image.path, "Error: Image data corrupted.\n" + image.path);
+    } else {
+        target->setImage(image.path, image.pyramid);
+        target->setView(m_zoom, m_center);
+    }
+    if (pane == m_activePane) reportStatus();
+}
+
+void CompareView::step(int delta)
+{
+    int index = m_indexes.at(m_activePane) + delta;
+    if (index < 0 || index >= m_images.size()) return;
+
+    // Only the active pane changes, the others keep their pixels and frame caches
+    load(m_activePane, index);
+    prefetchAfter(index);
+    reportStatus();
+}
+
+void CompareView::setActivePane(int pane)
+{
+    m_activePane = pane;
+    for (int i = 0; i < m_panes.size(); ++i) {
+        m_panes.at(i)->setActive(i == pane);
+    }
+    prefetchAfter(m_indexes.at(pane));
+    reportStatus();
+}
+
+void CompareView::prefetchAfter(int index)
+{
+    QStringList wanted;
+    for (int offset = 1; offset <= PREFETCH_AHEAD; ++offset) {
+        if (index + offset < m_images.size()) wanted << m_images.at(index + offset);
+    }
+    for (int offset = 1; offset <= PREFETCH_BEHIND; ++offset) {
+        if (index - offset >= 0) wanted << m_images.at(index - offset);
+    }
+
+    for (const QString &path : std::as_const(m_prefetchPaths)) {
+        if (!wanted.contains(path)) ImageCache::instance()->cancelPrefetch(path);
+    }
+    QStringList previous = m_prefetchPaths;
+    m_prefetchPaths.clear();
+    for (const QString &path : std::as_const(wanted)) {
+        if (VectorRenderer::isVectorFile(path)) continue;
+        if (!previous.contains(path)) {
+            ImageCache::instance()->prefetch(path, currentPriority(TaskScheduler::Prefetch));
+        }
+        m_prefetchPaths << path;
+    }
+}
+
+void CompareView::updatePriorities()
+{
+    ImageCache *cache = ImageCache::instance();
+    for (ComparePane *pane : std::as_const(m_panes)) {
+        if (!pane->pendingPath.isEmpty()) {
+            cache->setPriority(pane->pendingPath, currentPriority(TaskScheduler::Visible));
+        }
+    }
+    for (const QString &path : std::as_const(m_prefetchPaths)) {
+        cache->setPriority(path, currentPriority(TaskScheduler::Prefetch));
+    }
+}
+
+void CompareView::applyView()
+{
+    // Synchronous on purpose: every pane is moved before control returns to the
+    // event loop, so they all repaint in the same frame
+    for (ComparePane *pane : std::as_const(m_panes)) {
+        pane->setView(m_zoom, m_center);
+    }
+    reportStatus();
+}
+
+void CompareView::zoomAt(int pane, double zoom, const QPoint &anchor)
+{
+    ComparePane *source = m_panes.at(pane);
+    if (!source->hasImage()) return;
+
+    // Keep the image point under the cursor in place on the pane being zoomed,
+    // the others follow with the same center
+    QPointF fraction = source->imageFractionAt(anchor);
+    m_zoom = qBound(ZoomMath::MIN_ZOOM, zoom, ZoomMath::maxZoom(source->actualSizeFactor()));
+
+    QSizeF size = source->canvasSizeFor(m_zoom);
+    QSizeF viewportSize = source->viewport()->size();
+    QPointF center = m_center;
+    if (size.width() > 0) center.setX(fraction.x() + (viewportSize.width() / 2.0 - anchor.x()) / size.width());
+    if (size.height() > 0) center.setY(fraction.y() + (viewportSize.height() / 2.0 - anchor.y()) / size.height());
+    m_center = QPointF(qBound(0.0, center.x(), 1.0), qBound(0.0, center.y(), 1.0));
+    applyView();
+}
+
+void CompareView::reportStatus()
+{
+    ComparePane *pane = m_panes.at(m_activePane);
+    int index = m_indexes.at(m_activePane);
+    QString status = QString("Compare: pane %1 / %2  |  Index: %3 / %4  |  Zoom: %5%")
+        .arg(m_activePane + 1).arg(m_panes.size())
+        .arg(index + 1).arg(m_images.size())
+        .arg(qRound(m_zoom * 100));
+    if (pane->hasImage()) {
+        status += QString("  |  %1 x %2").arg(pane->imageSize().width()).arg(pane->imageSize().height());
+    }
+    emit statusChanged(status);
+}
+
+void CompareView::keyPressEvent(QKeyEvent *event)
+{
+    if (event->key() == Qt::Key_Left) {
+        step(-1);
+    } else if (event->key() == Qt::Key_Right) {
+        step(1);
+    } else if (event->key() == Qt::Key_Tab || event->key() == Qt::Key_Backtab) {
+        int delta = event->key() == Qt::Key_Tab ? 1 : -1;
+        setActivePane((m_activePane + delta + m_panes.size()) % m_panes.size());
+    } else if (event->key() == Qt::Key_Escape) {
+        m_zoom = 1.0;
+        m_center = QPointF(0.5, 0.5);
+        applyView();
+    } else {
+        QWidget::keyPressEvent(event);
+    }
+}
+
+bool CompareView::focusNextPrevChild(bool)
+{
+    // Tab cycles the panes instead of moving focus out of the view
+    return false;
+}
+
+void CompareView::showEvent(QShowEvent *event)
+{
+    QWidget::showEvent(event);
+    updatePriorities();
+}
+
+void CompareView::hideEvent(QHideEvent *event)
+{
+    QWidget::hideEvent(event);
+    updatePriorities();
+}
+
+bool CompareView::eventFilter(QObject *watched, QEvent *event)
+{
+    int pane = -1;
+    for (int i = 0; i < m_panes.size(); ++i) {
+        if (m_panes.at(i)->viewport() == watched) pane = i;
+    }
+    if (pane < 0) return QWidget::eventFilter(watched, event);
+
+    QWidget *viewport = m_panes.at(pane)->viewport();
+    switch (event->type()) {
+    case QEvent::Wheel: {
+        QWheelEvent *wheel = static_cast<QWheelEvent*>(event);
+        zoomAt(pane, m_zoom * ZoomMath::wheelFactor(wheel), wheel->position().toPoint());
+        return true;
+    }
+    case QEvent::MouseButtonPress: {
+        QMouseEvent *mouse = static_cast<QMouseEvent*>(event);
+        if (mouse->button() == Qt::LeftButton) {
+            if (pane != m_activePane) setActivePane(pane);
+            m_dragging = true;
+            m_lastMousePos = mouse->globalPosition().toPoint();
+            viewport->setCursor(Qt::ClosedHandCursor);
+            return true;
+        }
+        break;
+    }
+    case QEvent::MouseMove: {
+        QMouseEvent *mouse = static_cast<QMouseEvent*>(event);
+        if (m_dragging) {
+            QPoint delta = mouse->globalPosition().toPoint() - m_lastMousePos;
+            m_lastMousePos = mouse->globalPosition().toPoint();
+
+            // Pan in the dragged pane's pixels, so the image follows the cursor there
+            QSizeF size = m_panes.at(pane)->canvasSizeFor(m_zoom);
+            QSizeF viewportSize = viewport->size();
+            QPointF center = m_center;
+            if (size.width() > viewportSize.width()) {
+                double half = viewportSize.width() / 2.0 / size.width();
+                center.setX(qBound(half, center.x() - delta.x() / size.width(), 1.0 - half));
+            }
+            if (size.height() > viewportSize.height()) {
+                double half = viewportSize.height() / 2.0 / size.height();
+                center.setY(qBound(half, center.y() - delta.y() / size.height(), 1.0 - half));
+            }
+            if (center != m_center) {
+                m_center = center;
+                applyView();
+            }
+            return true;
+        }
+        break;
+    }
+    case QEvent::MouseButtonRelease: {
+        QMouseEvent *mouse = static_cast<QMouseEvent*>(event);
+        if (mouse->button() == Qt::LeftButton && m_dragging) {
+            m_dragging = false;
+            viewport->setCursor(Qt::OpenHandCursor);
+            return true;
+        }
+        break;
+    }
+    case QEvent::MouseButtonDblClick: {
+        QMouseEvent *mouse = static_cast<QMouseEvent*>(event);
+        // Fit <-> 1:1 of the clicked pane, around the clicked point
+        double target = qAbs(m_zoom - 1.0) < 0.001 ? m_panes.at(pane)->actualSizeFactor() : 1.0;
+        zoomAt(pane, target, mouse->position().toPoint());
+        return true;
+    }
+    default:
+        break;
+    }
+    return QWidget::eventFilter(watched, event);
+}
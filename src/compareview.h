@@ -0,0 +1,110 @@
+#ifndef COMPAREVIEW_H
+#define COMPAREVIEW_H
+
+#include <QWidget>
+#include <QList>
+#include <QStringList>
+#include "imagepyramid.h"
+#include "taskscheduler.h"
+
+class ImageCanvas;
+class QLabel;
+struct DecodedImage;
+
+// One image of a compare view. No scroll area: the canvas is placed by hand
+// from the shared zoom / center, so every pane can be moved in the same call.
+class ComparePane : public QWidget
+{
+    Q_OBJECT
+public:
+    explicit ComparePane(QWidget *parent = nullptr);
+
+    void setImage(const QString &path, const ImagePyramid &pyramid);
+    void setMessage(const QString &path, const QString &message);
+    QString path() const;
+    bool hasImage() const;
+    QSize imageSize() const;
+
+    // zoom is relative to this pane's Fit, center is a fraction of the image
+    void setView(double zoom, const QPointF &center);
+    QSizeF canvasSizeFor(double zoom) const;
+    QWidget *viewport() const;
+    // pos in viewport coordinates
+    QPointF imageFractionAt(const QPoint &pos) const;
+    double actualSizeFactor() const;
+
+    void setActive(bool active);
+
+    // Outstanding ImageCache request, released when the pane moves on
+    QString pendingPath;
+
+protected:
+    void resizeEvent(QResizeEvent *event) override;
+    void paintEvent(QPaintEvent *event) override;
+
+private:
+    void placeCanvas();
+
+    QWidget *m_viewport; // Clips the canvas inside the active frame
+    ImageCanvas *m_canvas;
+    QLabel *m_label;
+    QString m_path;
+    ImagePyramid m_pyramid;
+    double m_zoom;
+    QPointF m_center;
+    bool m_active;
+};
+
+// 2 to 4 images side by side with zoom and pan locked together, for culling
+// bursts. Panes share decoded pyramids with every tab through ImageCache.
+// Left/Right step only the active pane through the folder and prefetch the
+// images after it; input on any pane moves all of them in the same frame.
+class CompareView : public QWidget
+{
+    Q_OBJECT
+public:
+    static constexpr int MIN_PANES = 2;
+    static constexpr int MAX_PANES = 4;
+
+    // images: the folder order to step through, shown: index into it per pane
+    CompareView(const QStringList &images, const QList<int> &shown, QWidget *parent = nullptr);
+    ~CompareView();
+
+signals:
+    void statusChanged(const QString &message);
+
+protected:
+    void keyPressEvent(QKeyEvent *event) override;
+    bool focusNextPrevChild(bool next) override;
+    void showEvent(QShowEvent *event) override;
+    void hideEvent(QHideEvent *event) override;
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
+private:
+    void load(int pane, int index);
+    void showDecoded(int pane, const DecodedImage &image);
+    void step(int delta);
+    void setActivePane(int pane);
+    void prefetchAfter(int index);
+    void updatePriorities();
+    TaskScheduler::Priority currentPriority(TaskScheduler::Priority whenVisible) const;
+
+    void applyView();
+    void zoomAt(int pane, double zoom, const QPoint &anchor);
+    void reportStatus();
+
+    QStringList m_images;
+    QList<ComparePane *> m_panes;
+    QList<int> m_indexes;
+    QStringList m_prefetchPaths;
+    int m_activePane;
+
+    // Shared by all panes
+    double m_zoom;
+    QPointF m_center;
+
+    bool m_dragging;
+    QPoint m_lastMousePos;
+};
+
+#endif // COMPAREVIEW_H
@@ -0,0 +1,162 @@
+#include "folderwatcher.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QFileSystemWatcher>
+#include <QSocketNotifier>
+#include <QTimer>
+#ifdef Q_OS_LINUX
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    // Fallback: a file counts as written once its size held still this long
+    constexpr int SETTLE_INTERVAL_MS = 250;
+}
+
+FolderWatcher::FolderWatcher(const QString &folder, QObject *parent)
+    : QObject(parent)
+    , m_folder(QDir(folder).absolutePath())
+    , m_fd(-1)
+    , m_watch(-1)
+    , m_notifier(nullptr)
+    , m_fsWatcher(nullptr)
+    , m_settleTimer(nullptr)
+{
+#ifdef Q_OS_LINUX
+    m_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_fd >= 0) {
+        m_watch = inotify_add_watch(m_fd, QFile::encodeName(m_folder).constData(),
+                                    IN_CLOSE_WRITE | IN_MOVED_TO | IN_DELETE | IN_MOVED_FROM);
+        if (m_watch >= 0) {
+            m_notifier = new QSocketNotifier(m_fd, QSocketNotifier::Read, this);
+            connect(m_notifier, &QSocketNotifier::activated, this, &FolderWatcher::readEvents);
+            return;
+        }
+        ::close(m_fd);
+        m_fd = -1;
+    }
+#endif
+
+    // No inotify: diff the listing on change, then wait for sizes to settle
+    const QFileInfoList entries = QDir(m_folder).entryInfoList(QDir::Files | QDir::NoDotAndDotDot);
+    for (const QFileInfo &info : entries) {
+        m_known.insert(info.absoluteFilePath(), info.size());
+    }
+    m_fsWatcher = new QFileSystemWatcher(QStringList() << m_folder, this);
+    connect(m_fsWatcher, &QFileSystemWatcher::directoryChanged, this, &FolderWatcher::onDirectoryChanged);
+    m_settleTimer = new QTimer(this);
+    m_settleTimer->setInterval(SETTLE_INTERVAL_MS);
+    connect(m_settleTimer, &QTimer::timeout, this, &FolderWatcher::checkSettling);
+}
+
+FolderWatcher::~FolderWatcher()
+{
+#ifdef Q_OS_LINUX
+    if (m_fd >= 0) {
+        ::close(m_fd); // Also drops the watch
+    }
+#endif
+}
+
+bool FolderWatcher::isActive() const
+{
+    return m_notifier || m_fsWatcher;
+}
+
+QString FolderWatcher::folder() const
+{
+    return m_folder;
+}
+
+void FolderWatcher::readEvents()
+{
+#ifdef Q_OS_LINUX
+    QStringList ready;
+    QStringList removed;
+    bool overflow = false;
+
+    alignas(struct inotify_event) char buffer[16 * 1024];
+    for (;;) {
+        ssize_t length = ::read(m_fd, buffer, sizeof(buffer));
+        if (length <= 0) break;
+
+        for (char *ptr = buffer; ptr < buffer + length; ) {
+            const struct inotify_event *event = reinterpret_cast<const struct inotify_event *>(ptr);
+            ptr += sizeof(struct inotify_event) + event->len;
+
+            if (event->mask & IN_Q_OVERFLOW) {
+                overflow = true;
+                continue;
+            }
+            if (event->len == 0 || (event->mask & IN_ISDIR)) continue;
+
+            QString path = m_folder + QLatin1Char('/') + QFile::decodeName(event->name);
+            if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) {
+                removed.removeAll(path);
+                if (!ready.contains(path)) ready << path;
+            } else if (event->mask & (IN_DELETE | IN_MOVED_FROM)) {
+                ready.removeAll(path);
+                removed << path;
+            }
+        }
+    }
+
+    if (overflow) {
+        emit overflowed();
+        return;
+    }
+    emitBatch(ready, removed);
+#endif
+}
+
+void FolderWatcher::onDirectoryChanged()
+{
+    QHash<QString, qint64> current;
+    const QFileInfoList entries = QDir(m_folder).entryInfoList(QDir::Files | QDir::NoDotAndDotDot);
+    for (const QFileInfo &info : entries) {
+        current.insert(info.absoluteFilePath(), info.size());
+    }
+
+    QStringList removed;
+    for (auto it = m_known.constBegin(); it != m_known.constEnd(); ++it) {
+        if (!current.contains(it.key())) removed << it.key();
+    }
+    for (const QString &path : std::as_const(removed)) {
+        m_known.remove(path);
+    }
+    for (auto it = current.constBegin(); it != current.constEnd(); ++it) {
+        if (!m_known.contains(it.key())) m_settling.insert(it.key(), it.value());
+    }
+
+    emitBatch(QStringList(), removed);
+    if (!m_settling.isEmpty() && !m_settleTimer->isActive()) m_settleTimer->start();
+}
+
+void FolderWatcher::checkSettling()
+{
+    QStringList ready;
+    for (auto it = m_settling.begin(); it != m_settling.end(); ) {
+        QFileInfo info(it.key());
+        if (!info.exists()) {
+            it = m_settling.erase(it);
+        } else if (info.size() == it.value() && info.size() > 0) {
+            ready << it.key();
+            m_known.insert(it.key(), info.size());
+            it = m_settling.erase(it);
+        } else {
+            it.value() = info.size();
+            ++it;
+        }
+    }
+
+    if (m_settling.isEmpty()) m_settleTimer->stop();
+    emitBatch(ready, QStringList());
+}
+
+void FolderWatcher::emitBatch(const QStringList &ready, const QStringList &removed)
+{
+    if (!removed.isEmpty()) emit filesRemoved(removed);
+    if (!ready.isEmpty()) emit filesReady(ready);
+}
@@ -0,0 +1,52 @@
+#ifndef FOLDERWATCHER_H
+#define FOLDERWATCHER_H
+
+#include <QObject>
+#include <QHash>
+#include <QStringList>
+
+class QSocketNotifier;
+class QFileSystemWatcher;
+class QTimer;
+
+// Reports files appearing in / disappearing from one folder, one event per
+// change so callers can keep their index current in O(changes).
+// A file is only reported once it is completely written: on Linux inotify's
+// IN_CLOSE_WRITE / IN_MOVED_TO tell us directly, elsewhere we fall back to
+// QFileSystemWatcher and wait until the size stops changing.
+class FolderWatcher : public QObject
+{
+    Q_OBJECT
+public:
+    explicit FolderWatcher(const QString &folder, QObject *parent = nullptr);
+    ~FolderWatcher();
+
+    bool isActive() const;
+    QString folder() const;
+
+signals:
+    void filesReady(const QStringList &paths);   // New or rewritten, in arrival order
+    void filesRemoved(const QStringList &paths);
+    void overflowed();                            // Events were lost, rescan
+
+private slots:
+    void readEvents();
+    void onDirectoryChanged();
+    void checkSettling();
+
+private:
+    void emitBatch(const QStringList &ready, const QStringList &removed);
+
+    QString m_folder;
+    int m_fd;
+    int m_watch;
+    QSocketNotifier *m_notifier;
+
+    // Fallback without inotify
+    QFileSystemWatcher *m_fsWatcher;
+    QTimer *m_settleTimer;
+    QHash<QString, qint64> m_known;     // Reported files
+    QHash<QString, qint64> m_settling;  // Seen, size still changing
+};
+
+#endif // FOLDERWATCHER_H
@@ -0,0 +1,241 @@
+#include "histogram.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace {
+    // Pixels per stripe task. Short enough that Visible work never waits long
+    // behind a stripe, long enough that scheduling overhead does not show.
+    constexpr qint64 STRIPE_PIXELS = 1 << 20;
+
+    // Rec. 601 luma in 8.8 fixed point
+    constexpr int LUMA_R = 77;
+    constexpr int LUMA_G = 150;
+    constexpr int LUMA_B = 29;
+
+    inline int lumaOf(QRgb pixel)
+    {
+        return (qRed(pixel) * LUMA_R + qGreen(pixel) * LUMA_G + qBlue(pixel) * LUMA_B + 128) >> 8;
+    }
+
+    // Four sets of bins, one per lane. Consecutive pixels of the same color
+    // (very common) then don't serialize on incrementing the same counter.
+    struct LaneBins {
+        quint32 red[4][HistogramData::BINS] = {};
+        quint32 green[4][HistogramData::BINS] = {};
+        quint32 blue[4][HistogramData::BINS] = {};
+        quint32 luma[4][HistogramData::BINS] = {};
+        quint64 shadows = 0;
+        quint64 highlights = 0;
+
+        inline void add(int lane, QRgb pixel, int y)
+        {
+            const int r = qRed(pixel);
+            const int g = qGreen(pixel);
+            const int b = qBlue(pixel);
+            red[lane][r]++;
+            green[lane][g]++;
+            blue[lane][b]++;
+            luma[lane][y]++;
+            shadows += (r | g | b) == 0;
+            highlights += (r == 255) | (g == 255) | (b == 255);
+        }
+    };
+
+    void countOpaqueRow(const QRgb *line, int width, LaneBins &bins)
+    {
+        int x = 0;
+#if defined(__SSE2__)
+        // Luma for four pixels at a time. Channels are < 256 with zero upper
+        // halves, so madd_epi16 is a plain 32 bit multiply here.
+        const __m128i mask = _mm_set1_epi32(0xff);
+        const __m128i wr = _mm_set1_epi32(LUMA_R);
+        const __m128i wg = _mm_set1_epi32(LUMA_G);
+        const __m128i wb = _mm_set1_epi32(LUMA_B);
+        const __m128i round = _mm_set1_epi32(128);
+        alignas(16) quint32 luma[4];
+        for (; x + 4 <= width; x += 4) {
+            const __m128i px = _mm_loadu_si128(reinterpret_cast<const __m128i *>(line + x));
+            const __m128i b = _mm_and_si128(px, mask);
+            const __m128i g = _mm_and_si128(_mm_srli_epi32(px, 8), mask);
+            const __m128i r = _mm_and_si128(_mm_srli_epi32(px, 16), mask);
+            __m128i y = _mm_add_epi32(_mm_madd_epi16(r, wr), _mm_madd_epi16(g, wg));
+            y = _mm_add_epi32(y, _mm_madd_epi16(b, wb));
+            y = _mm_srli_epi32(_mm_add_epi32(y, round), 8);
+            _mm_store_si128(reinterpret_cast<__m128i *>(luma), y);
+
+            bins.add(0, line[x], luma[0]);
+            bins.add(1, line[x + 1], luma[1]);
+            bins.add(2, line[x + 2], luma[2]);
+            bins.add(3, line[x + 3], luma[3]);
+        }
+#else
+        for (; x + 4 <= width; x += 4) {
+            bins.add(0, line[x], lumaOf(line[x]));
+            bins.add(1, line[x + 1], lumaOf(line[x + 1]));
+            bins.add(2, line[x + 2], lumaOf(line[x + 2]));
+            bins.add(3, line[x + 3], lumaOf(line[x + 3]));
+        }
+#endif
+        for (; x < width; ++x) {
+            bins.add(0, line[x], lumaOf(line[x]));
+        }
+    }
+
+    void countPremultipliedRow(const QRgb *line, int width, LaneBins &bins)
+    {
+        // Transparent pixels have no color to count, partial ones are unpremultiplied first
+        for (int x = 0; x < width; ++x) {
+            const QRgb pixel = line[x];
+            const int alpha = qAlpha(pixel);
+            if (alpha == 0) continue;
+            const QRgb color = alpha == 255 ? pixel : qUnpremultiply(pixel);
+            bins.add(x & 3, color, lumaOf(color));
+        }
+    }
+}
+
+void HistogramData::merge(const HistogramData &other)
+{
+    for (int i = 0; i < BINS; ++i) {
+        red[i] += other.red[i];
+        green[i] += other.green[i];
+        blue[i] += other.blue[i];
+        luma[i] += other.luma[i];
+    }
+    pixels += other.pixels;
+    lumaSum += other.lumaSum;
+    clippedShadows += other.clippedShadows;
+    clippedHighlights += other.clippedHighlights;
+    approximate = approximate || other.approximate;
+}
+
+double HistogramData::meanLuma() const
+{
+    return pixels ? double(lumaSum) / pixels : 0.0;
+}
+
+double HistogramData::shadowClipPercent() const
+{
+    return pixels ? 100.0 * clippedShadows / pixels : 0.0;
+}
+
+double HistogramData::highlightClipPercent() const
+{
+    return pixels ? 100.0 * clippedHighlights / pixels : 0.0;
+}
+
+Histogram::Histogram(QObject *parent)
+    : QObject(parent)
+    , m_stripesLeft(0)
+    , m_generation(0)
+{
+}
+
+Histogram::~Histogram()
+{
+    // Stripes only read their own (shared) copy of the image
+    cancelStripes();
+}
+
+HistogramData Histogram::count(const QImage &image, int firstRow, int lastRow)
+{
+    HistogramData result;
+    if (image.isNull()) return result;
+
+    const bool opaque = image.format() == QImage::Format_RGB32;
+    const QImage source = (opaque || image.format() == QImage::Format_ARGB32_Premultiplied)
+        ? image : image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+
+    // Large, keep it off the worker's stack
+    QScopedPointer<LaneBins> bins(new LaneBins);
+    firstRow = qMax(0, firstRow);
+    lastRow = qMin(source.height(), lastRow);
+    for (int y = firstRow; y < lastRow; ++y) {
+        const QRgb *line = reinterpret_cast<const QRgb *>(source.constScanLine(y));
+        if (opaque) {
+            countOpaqueRow(line, source.width(), *bins);
+        } else {
+            countPremultipliedRow(line, source.width(), *bins);
+        }
+    }
+
+    for (int i = 0; i < HistogramData::BINS; ++i) {
+        for (int lane = 0; lane < 4; ++lane) {
+            result.red[i] += bins->red[lane][i];
+            result.green[i] += bins->green[lane][i];
+            result.blue[i] += bins->blue[lane][i];
+            result.luma[i] += bins->luma[lane][i];
+        }
+        result.pixels += result.luma[i];
+        result.lumaSum += quint64(result.luma[i]) * i;
+    }
+    result.clippedShadows = bins->shadows;
+    result.clippedHighlights = bins->highlights;
+    return result;
+}
+
+void Histogram::setImage(const ImagePyramid &pyramid, TaskScheduler::Priority priority)
+{
+    clear();
+    if (pyramid.isNull()) return;
+
+    // Instant preview from the smallest level
+    const QImage &preview = pyramid.level(pyramid.levelCount() - 1);
+    m_data = count(preview, 0, preview.height());
+    m_data.approximate = pyramid.levelCount() > 1;
+    emit updated();
+    if (!m_data.approximate) return;
+
+    // Exact counts from the full resolution buffer, one task per stripe of rows
+    const QImage base = pyramid.base();
+    const int stripeRows = int(qMax<qint64>(1, STRIPE_PIXELS / qMax(1, base.width())));
+    const quint64 generation = m_generation;
+    for (int y = 0; y < base.height(); y += stripeRows) {
+        const int lastRow = qMin(base.height(), y + stripeRows);
+        m_stripesLeft++;
+        m_stripes << TaskScheduler::instance()->submit<HistogramData>(priority, QString(), this,
+            [base, y, lastRow](const TaskContext &) { return count(base, y, lastRow); },
+            [this, generation](const HistogramData &part) {
+                if (generation != m_generation) return;
+                m_exact.merge(part);
+                if (--m_stripesLeft == 0) {
+                    m_data = m_exact;
+                    m_stripes.clear();
+                    emit updated();
+                }
+            });
+    }
+}
+
+void Histogram::clear()
+{
+    cancelStripes();
+    m_generation++;
+    const bool hadData = m_data.isValid();
+    m_data = HistogramData();
+    m_exact = HistogramData();
+    if (hadData) emit updated();
+}
+
+void Histogram::setPriority(TaskScheduler::Priority priority)
+{
+    for (TaskHandle &stripe : m_stripes) {
+        stripe.setPriority(priority);
+    }
+}
+
+const HistogramData &Histogram::data() const
+{
+    return m_data;
+}
+
+void Histogram::cancelStripes()
+{
+    for (TaskHandle &stripe : m_stripes) {
+        stripe.cancel();
+    }
+    m_stripes.clear();
+    m_stripesLeft = 0;
+}
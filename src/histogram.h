@@ -0,0 +1,65 @@
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include <QObject>
+#include <QImage>
+#include <QList>
+#include <array>
+#include "imagepyramid.h"
+#include "taskscheduler.h"
+
+// Channel and luma counts of one image, plus the exposure numbers derived from them
+struct HistogramData {
+    static constexpr int BINS = 256;
+
+    std::array<quint32, BINS> red = {};
+    std::array<quint32, BINS> green = {};
+    std::array<quint32, BINS> blue = {};
+    std::array<quint32, BINS> luma = {};
+    quint64 pixels = 0;
+    quint64 lumaSum = 0;
+    quint64 clippedShadows = 0;    // All channels at 0
+    quint64 clippedHighlights = 0; // Any channel at 255
+    bool approximate = false;      // Counted on a downscaled pyramid level
+
+    bool isValid() const { return pixels > 0; }
+    void merge(const HistogramData &other);
+    double meanLuma() const;
+    double shadowClipPercent() const;
+    double highlightClipPercent() const;
+};
+
+// Keeps the histogram of the current image up to date without touching the
+// GUI thread for more than a preview: the smallest pyramid level is counted
+// synchronously (tens of thousands of pixels) and shown as approximate, then
+// the full resolution buffer is counted in row stripes on the TaskScheduler
+// pool and the exact result replaces it once every stripe is in.
+class Histogram : public QObject
+{
+    Q_OBJECT
+public:
+    explicit Histogram(QObject *parent = nullptr);
+    ~Histogram();
+
+    // Row range [firstRow, lastRow) of an RGB32 / ARGB32_Premultiplied image
+    static HistogramData count(const QImage &image, int firstRow, int lastRow);
+
+    void setImage(const ImagePyramid &pyramid, TaskScheduler::Priority priority);
+    void clear();
+    void setPriority(TaskScheduler::Priority priority);
+    const HistogramData &data() const;
+
+signals:
+    void updated();
+
+private:
+    void cancelStripes();
+
+    HistogramData m_data;
+    HistogramData m_exact; // Stripes merged so far
+    QList<TaskHandle> m_stripes;
+    int m_stripesLeft;
+    quint64 m_generation;
+};
+
+#endif // HISTOGRAM_H
@@ -0,0 +1,111 @@
+#include "histogramoverlay.h"
+#include "histogram.h"
+#include <QFontMetrics>
+#include <QPainter>
+#include <QPainterPath>
+
+namespace {
+    constexpr int MARGIN = 10;
+    constexpr int GRAPH_HEIGHT = 100;
+    // Share of the image that has to clip before the number turns red
+    constexpr double CLIP_WARNING_PERCENT = 0.5;
+
+    QPainterPath histogramPath(const std::array<quint32, HistogramData::BINS> &bins,
+                               double peak, const QRectF &area, bool closed)
+    {
+        QPainterPath path;
+        const double step = area.width() / (HistogramData::BINS - 1);
+        for (int i = 0; i < HistogramData::BINS; ++i) {
+            const double y = area.bottom() - qMin(1.0, bins[i] / peak) * area.height();
+            const QPointF point(area.left() + i * step, y);
+            if (i == 0) {
+                if (closed) {
+                    path.moveTo(area.bottomLeft());
+                    path.lineTo(point);
+                } else {
+                    path.moveTo(point);
+                }
+            } else {
+                path.lineTo(point);
+            }
+        }
+        if (closed) {
+            path.lineTo(area.bottomRight());
+            path.closeSubpath();
+        }
+        return path;
+    }
+}
+
+HistogramOverlay::HistogramOverlay(Histogram *histogram, QObject *parent)
+    : OverlayItem(parent)
+    , m_histogram(histogram)
+{
+    connect(m_histogram, &Histogram::updated, this, &OverlayItem::changed);
+}
+
+QSize HistogramOverlay::sizeHint() const
+{
+    return QSize(256 + 2 * MARGIN, GRAPH_HEIGHT + 2 * MARGIN + 2 * QFontMetrics(QFont()).height() + 4);
+}
+
+void HistogramOverlay::paint(QPainter &p, const QSize &size) const
+{
+    p.setRenderHint(QPainter::Antialiasing);
+
+    // Same pill style as the navigation HUD
+    p.setPen(Qt::NoPen);
+    p.setBrush(QColor(0, 0, 0, 150));
+    p.drawRoundedRect(QRectF(QPointF(0, 0), QSizeF(size)), 12, 12);
+
+    const HistogramData &data = m_histogram->data();
+    const QRectF graph(MARGIN, MARGIN, size.width() - 2 * MARGIN, GRAPH_HEIGHT);
+    p.setPen(QColor(255, 255, 255, 40));
+    p.setBrush(Qt::NoBrush);
+    p.drawRect(graph);
+
+    p.setPen(Qt::white);
+    if (!data.isValid()) {
+        p.drawText(graph, Qt::AlignCenter, "No image");
+        return;
+    }
+
+    // Scale to the tallest interior bin; clipped end bins would flatten everything else
+    quint32 peak = 1;
+    for (int i = 1; i < HistogramData::BINS - 1; ++i) {
+        peak = qMax(peak, qMax(data.luma[i], qMax(data.red[i], qMax(data.green[i], data.blue[i]))));
+    }
+
+    p.setPen(Qt::NoPen);
+    p.setBrush(QColor(200, 200, 200, 110));
+    p.drawPath(histogramPath(data.luma, peak, graph, true));
+
+    p.setBrush(Qt::NoBrush);
+    p.setPen(QPen(QColor(255, 80, 80, 200), 1));
+    p.drawPath(histogramPath(data.red, peak, graph, false));
+    p.setPen(QPen(QColor(80, 220, 80, 200), 1));
+    p.drawPath(histogramPath(data.green, peak, graph, false));
+    p.setPen(QPen(QColor(90, 140, 255, 200), 1));
+    p.drawPath(histogramPath(data.blue, peak, graph, false));
+
+    // Stats, clipping in red once it matters
+    const int lineHeight = p.fontMetrics().height();
+    QRectF text(MARGIN, graph.bottom() + 4, graph.width(), lineHeight);
+    p.setPen(Qt::white);
+    p.drawText(text, Qt::AlignLeft | Qt::AlignVCenter,
+               QString("Mean %1").arg(data.meanLuma(), 0, 'f', 1));
+    if (data.approximate) {
+        p.setPen(QColor(255, 255, 255, 140));
+        p.drawText(text, Qt::AlignRight | Qt::AlignVCenter, "approx.");
+    }
+
+    text.translate(0, lineHeight);
+    const double shadows = data.shadowClipPercent();
+    const double highlights = data.highlightClipPercent();
+    p.setPen(shadows > CLIP_WARNING_PERCENT ? QColor(255, 90, 90) : QColor(Qt::white));
+    p.drawText(text, Qt::AlignLeft | Qt::AlignVCenter,
+               QString("Shadows %1%").arg(shadows, 0, 'f', 2));
+    p.setPen(highlights > CLIP_WARNING_PERCENT ? QColor(255, 90, 90) : QColor(Qt::white));
+    p.drawText(text, Qt::AlignRight | Qt::AlignVCenter,
+               QString("Highlights %1%").arg(highlights, 0, 'f', 2));
+}
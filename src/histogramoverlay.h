@@ -0,0 +1,24 @@
+#ifndef HISTOGRAMOVERLAY_H
+#define HISTOGRAMOVERLAY_H
+
+#include "overlaylayer.h"
+
+class Histogram;
+
+// Semi-transparent panel drawn over the image: luma and RGB histogram plus
+// mean brightness and clipped shadow / highlight percentages. Purely a view
+// of Histogram::data(), redrawn whenever the histogram updates.
+class HistogramOverlay : public OverlayItem
+{
+    Q_OBJECT
+public:
+    explicit HistogramOverlay(Histogram *histogram, QObject *parent = nullptr);
+
+    QSize sizeHint() const override;
+    void paint(QPainter &p, const QSize &size) const override;
+
+private:
+    Histogram *m_histogram;
+};
+
+#endif // HISTOGRAMOVERLAY_H
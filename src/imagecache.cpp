@@ -0,0 +1,174 @@
+#include "imagecache.h"
+#include "ziparchive.h"
+#include <QCoreApplication>
+#include <algorithm>
+
+ImageCache::ImageCache(QObject *parent)
+    : QObject(parent)
+    , m_useCounter(0)
+    , m_bytes(0)
+{
+    connect(MemoryBudget::instance(), &MemoryBudget::pressure, this, [this]() { trim(QString()); });
+}
+
+ImageCache *ImageCache::instance()
+{
+    static ImageCache *cache = new ImageCache(QCoreApplication::instance());
+    return cache;
+}
+
+bool ImageCache::request(const QString &path, TaskScheduler::Priority priority, QObject *receiver, Callback callback)
+{
+    auto it = m_entries.find(path);
+    if (it != m_entries.end()) {
+        it->lastUsed = ++m_useCounter;
+        callback(it->image);
+        return true;
+    }
+
+    startDecode(path, priority);
+    m_pending[path].waiters.append(Waiter{receiver, std::move(callback)});
+    return false;
+}
+
+void ImageCache::release(const QString &path, QObject *receiver)
+{
+    auto it = m_pending.find(path);
+    if (it == m_pending.end()) return;
+
+    auto &waiters = it->waiters;
+    waiters.erase(std::remove_if(waiters.begin(), waiters.end(), [receiver](const Waiter &waiter) {
+        return !waiter.receiver || waiter.receiver == receiver;
+    }), waiters.end());
+    cancelIfUnwanted(path);
+}
+
+void ImageCache::prefetch(const QString &path, TaskScheduler::Priority priority)
+{
+    if (m_entries.contains(path)) return;
+    startDecode(path, priority);
+    m_pending[path].prefetchRefs++;
+}
+
+void ImageCache::cancelPrefetch(const QString &path)
+{
+    auto it = m_pending.find(path);
+    if (it == m_pending.end()) return;
+    if (it->prefetchRefs > 0) it->prefetchRefs--;
+    cancelIfUnwanted(path);
+}
+
+void ImageCache::setPriority(const QString &path, TaskScheduler::Priority priority)
+{
+    auto it = m_pending.find(path);
+    if (it == m_pending.end() || it->priority == priority) return;
+    it->priority = priority;
+    it->task.setPriority(priority);
+}
+
+void ImageCache::invalidate(const QString &path)
+{
+    auto it = m_entries.find(path);
+    if (it == m_entries.end()) return;
+    m_bytes -= it->bytes;
+    m_entries.erase(it);
+    m_charge.set(m_bytes);
+}
+
+bool ImageCache::contains(const QString &path) const
+{
+    return m_entries.contains(path);
+}
+
+DecodedImage ImageCache::cached(const QString &path)
+{
+    auto it = m_entries.find(path);
+    if (it == m_entries.end()) return DecodedImage();
+    it->lastUsed = ++m_useCounter;
+    return it->image;
+}
+
+qint64 ImageCache::byteCount() const
+{
+    return m_bytes;
+}
+
+void ImageCache::startDecode(const QString &path, TaskScheduler::Priority priority)
+{
+    auto it = m_pending.find(path);
+    if (it != m_pending.end()) {
+        // Already queued, make it at least as urgent as this request
+        if (priority < it->priority) {
+            it->priority = priority;
+            it->task.setPriority(priority);
+        }
+        return;
+    }
+
+    Pending pending;
+    pending.priority = priority;
+    // Archive members count against the device of the archive file
+    pending.task = TaskScheduler::instance()->submit<DecodedImage>(priority, ZipArchive::physicalPath(path), this,
+        [path](const TaskContext &ctx) {
+            // The device slot covers the read only, decoding runs on any worker
+            bool ok = false;
+            const QByteArray data = ImageDecoder::readSource(path, &ok);
+            ctx.releaseIo();
+            if (!ok) {
+                DecodedImage failed;
+                failed.path = path;
+                failed.error = DecodedImage::CannotRead;
+                return failed;
+            }
+            return ImageDecoder::decode(path, data);
+        },
+        [this](const DecodedImage &image) { onDecoded(image); });
+    m_pending.insert(path, pending);
+}
+
+void ImageCache::cancelIfUnwanted(const QString &path)
+{
+    auto it = m_pending.find(path);
+    if (it == m_pending.end()) return;
+    if (it->waiters.isEmpty() && it->prefetchRefs == 0) {
+        it->task.cancel();
+        m_pending.erase(it);
+    }
+}
+
+void ImageCache::onDecoded(const DecodedImage &image)
+{
+    Pending pending = m_pending.take(image.path);
+
+    // Failures are not cached, the file may still be being written
+    if (image.isValid()) {
+        Entry entry;
+        entry.image = image;
+        entry.bytes = image.pyramid.byteCount();
+        entry.lastUsed = ++m_useCounter;
+        m_entries.insert(image.path, entry);
+        m_bytes += entry.bytes;
+        m_charge.set(m_bytes);
+        trim(image.path);
+    }
+
+    for (const Waiter &waiter : pending.waiters) {
+        if (waiter.receiver) waiter.callback(image);
+    }
+}
+
+void ImageCache::trim(const QString &keep)
+{
+    while (MemoryBudget::instance()->isOverBudget() && m_entries.size() > 1) {
+        auto oldest = m_entries.end();
+        for (auto it = m_entries.begin(); it != m_entries.end(); ++it) {
+            if (it.key() == keep) continue;
+            if (oldest == m_entries.end() || it->lastUsed < oldest->lastUsed) oldest = it;
+        }
+        if (oldest == m_entries.end()) break;
+
+        m_bytes -= oldest->bytes;
+        m_entries.erase(oldest);
+    }
+    m_charge.set(m_bytes);
+}
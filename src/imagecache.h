@@ -0,0 +1,73 @@
+#ifndef IMAGECACHE_H
+#define IMAGECACHE_H
+
+#include <QObject>
+#include <QHash>
+#include <QPointer>
+#include <functional>
+#include "imagedecoder.h"
+#include "memorybudget.h"
+#include "taskscheduler.h"
+
+// Decoded images shared by every tab. Decodes run on the TaskScheduler at the
+// priority of their most urgent requester; entries are dropped least recently
+// used first once the global memory budget is exceeded.
+class ImageCache : public QObject
+{
+    Q_OBJECT
+public:
+    using Callback = std::function<void(const DecodedImage &)>;
+
+    static ImageCache *instance();
+
+    // Cached: calls back right away and returns true. Otherwise the callback
+    // runs on the GUI thread once decoded, as long as receiver is alive.
+    bool request(const QString &path, TaskScheduler::Priority priority, QObject *receiver, Callback callback);
+    // Receiver lost interest, the decode is cancelled if nobody else wants it
+    void release(const QString &path, QObject *receiver);
+
+    // Warm the cache without waiting for the result
+    void prefetch(const QString &path, TaskScheduler::Priority priority);
+    void cancelPrefetch(const QString &path);
+
+    void setPriority(const QString &path, TaskScheduler::Priority priority);
+
+    // File changed on disk: forget the decoded copy
+    void invalidate(const QString &path);
+
+    bool contains(const QString &path) const;
+    DecodedImage cached(const QString &path);
+    qint64 byteCount() const;
+
+private:
+    explicit ImageCache(QObject *parent = nullptr);
+
+    struct Waiter {
+        QPointer<QObject> receiver;
+        Callback callback;
+    };
+    struct Pending {
+        TaskHandle task;
+        QList<Waiter> waiters;
+        int prefetchRefs = 0;
+        TaskScheduler::Priority priority = TaskScheduler::Background;
+    };
+    struct Entry {
+        DecodedImage image;
+        qint64 bytes = 0;
+        quint64 lastUsed = 0;
+    };
+
+    void startDecode(const QString &path, TaskScheduler::Priority priority);
+    void onDecoded(const DecodedImage &image);
+    void cancelIfUnwanted(const QString &path);
+    void trim(const QString &keep);
+
+    QHash<QString, Entry> m_entries;
+    QHash<QString, Pending> m_pending;
+    quint64 m_useCounter;
+    qint64 m_bytes;
+    MemoryCharge m_charge;
+};
+
+#endif // IMAGECACHE_H
@@ -0,0 +1,210 @@
+#include "imagecanvas.h"
+#include "painttrace.h"
+#include "vectorrenderer.h"
+#include <QElapsedTimer>
+#include <QPainter>
+#include <QPaintEvent>
+
+ImageCanvas::ImageCanvas(QWidget *parent)
+    : QWidget(parent)
+    , m_vectorRenderer(nullptr)
+    , m_animating(false)
+    , m_fastPaint(false)
+    , m_frameBudgetMs(0.0)
+    , m_lastPaintMs(0.0)
+{
+    // Hidden canvases give their cached frame back first when memory runs short
+    connect(MemoryBudget::instance(), &MemoryBudget::pressure, this, [this]() {
+        if (!isVisible()) dropFrameCache();
+    });
+}
+
+void ImageCanvas::setImage(const ImagePyramid &pyramid)
+{
+    if (m_vectorRenderer) {
+        disconnect(m_vectorRenderer, nullptr, this, nullptr);
+        m_vectorRenderer = nullptr;
+    }
+    m_message.clear();
+    m_pyramid = pyramid;
+    update();
+}
+
+void ImageCanvas::setVectorSource(VectorRenderer *renderer, const ImagePyramid &fallback)
+{
+    if (m_vectorRenderer != renderer) {
+        if (m_vectorRenderer) disconnect(m_vectorRenderer, nullptr, this, nullptr);
+        m_vectorRenderer = renderer;
+        connect(m_vectorRenderer, &VectorRenderer::rendered, this, [this]() { update(); });
+    }
+    m_message.clear();
+    m_pyramid = fallback;
+    update();
+}
+
+void ImageCanvas::setMessage(const QString &message)
+{
+    setImage(ImagePyramid());
+    m_message = message;
+    resize(fontMetrics().boundingRect(QRect(0, 0, 2000, 2000), Qt::AlignCenter, m_message).size() + QSize(20, 20));
+    update();
+}
+
+void ImageCanvas::setBackground(const QBrush &brush)
+{
+    m_background = brush;
+    // Nothing underneath shows through, Qt can skip the viewport behind us
+    setAttribute(Qt::WA_OpaquePaintEvent, brush.isOpaque());
+    dropFrameCache();
+    update();
+}
+
+QBrush ImageCanvas::checkerboard()
+{
+    QPixmap checker(20, 20);
+    checker.fill(QColor(60, 60, 60));
+    QPainter p(&checker);
+    p.fillRect(0, 0, 10, 10, QColor(45, 45, 45));
+    p.fillRect(10, 10, 10, 10, QColor(45, 45, 45));
+    p.end();
+    return QBrush(checker);
+}
+
+void ImageCanvas::setAnimating(bool animating, double frameBudgetMs)
+{
+    m_animating = animating;
+    m_frameBudgetMs = frameBudgetMs;
+    if (!animating && m_fastPaint) {
+        // Settled: repaint once with full filtering
+        m_fastPaint = false;
+        update();
+    }
+}
+
+double ImageCanvas::lastPaintMs() const
+{
+    return m_lastPaintMs;
+}
+
+bool ImageCanvas::isFastPaint() const
+{
+    return m_fastPaint;
+}
+
+void ImageCanvas::dropFrameCache()
+{
+    m_frame = QPixmap();
+    m_frameKey = FrameKey();
+    m_frameCharge.set(0);
+}
+
+qint64 ImageCanvas::frameCacheBytes() const
+{
+    return m_frameCharge.bytes();
+}
+
+void ImageCanvas::paintEvent(QPaintEvent *event)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    QPainter painter(this);
+
+    if (m_pyramid.isNull()) {
+        if (m_background.style() != Qt::NoBrush) painter.fillRect(event->rect(), m_background);
+        if (!m_message.isEmpty()) painter.drawText(rect(), Qt::AlignCenter, m_message);
+        return;
+    }
+
+    QRect visible = visibleRegion().boundingRect();
+    if (m_animating || visible.isEmpty() || !visible.contains(event->rect())) {
+        // Frames in flight are thrown away right after, no point caching them
+        paintContent(painter, event->rect());
+    } else {
+        FrameKey key;
+        key.size = size();
+        key.visible = visible;
+        key.content = m_pyramid.base().cacheKey();
+        if (m_vectorRenderer) {
+            const VectorRenderer::Raster *raster = m_vectorRenderer->raster(size());
+            key.raster = raster ? raster->image.cacheKey() : 0;
+        }
+
+        const bool cached = !m_frame.isNull() && key == m_frameKey;
+        if (!cached && event->rect() != visible) {
+            // A pan step moved the visible rect and Qt only exposed the strip that
+            // scrolled in: paint just that. The old frame no longer matches anything.
+            if (!m_frame.isNull()) dropFrameCache();
+            paintContent(painter, event->rect());
+        } else {
+            // Full exposes (show, resize, new content) build the frame, anything
+            // smaller blits from it
+            if (!cached) {
+                const qreal dpr = devicePixelRatioF();
+                QPixmap frame(visible.size() * dpr);
+                frame.setDevicePixelRatio(dpr);
+                frame.fill(Qt::transparent);
+
+                QPainter framePainter(&frame);
+                framePainter.translate(-visible.topLeft());
+                paintContent(framePainter, visible);
+                framePainter.end();
+
+                m_frame = frame;
+                m_frameKey = key;
+                m_frameCharge.set(qint64(frame.width()) * frame.height() * frame.depth() / 8);
+            }
+            painter.drawPixmap(visible.topLeft(), m_frame);
+        }
+    }
+
+    m_lastPaintMs = timer.nsecsElapsed() / 1e6;
+    PaintTrace::instance()->record(PaintTrace::Canvas, event->region(), m_lastPaintMs);
+    if (m_animating) {
+        // Latched: the cheap frame that follows would come in under budget and
+        // flip back to smooth, alternating filtered and unfiltered frames
+        m_fastPaint = m_fastPaint || m_lastPaintMs > m_frameBudgetMs;
+    }
+}
+
+void ImageCanvas::paintContent(QPainter &painter, const QRect &exposed)
+{
+    // Opaque sources cover every pixel, the checkerboard would be painted over
+    if (m_background.style() != Qt::NoBrush && (m_vectorRenderer || m_pyramid.base().hasAlphaChannel())) {
+        painter.fillRect(exposed, m_background);
+    }
+    if (m_vectorRenderer) {
+        paintVector(painter, exposed);
+    } else {
+        paintPyramid(painter);
+    }
+}
+
+void ImageCanvas::paintPyramid(QPainter &painter)
+{
+    // Painter clip (or the frame cache bounds) limits the scaling work to the exposed rect
+    const double scale = double(width()) / m_pyramid.size().width();
+    painter.setRenderHint(QPainter::SmoothPixmapTransform, !m_fastPaint);
+    painter.drawImage(QRectF(rect()), m_pyramid.levelFor(scale));
+}
+
+void ImageCanvas::paintVector(QPainter &painter, const QRect &exposed)
+{
+    const VectorRenderer::Raster *raster = m_vectorRenderer->raster(size());
+
+    if (!raster || !raster->area.contains(exposed)) {
+        // Upscaled stand-in until the sharp raster arrives
+        paintPyramid(painter);
+
+        // Render what is visible plus half a screen around it, so small pans stay sharp
+        QRect visible = visibleRegion().boundingRect();
+        if (visible.isEmpty()) visible = exposed;
+        const int mx = visible.width() / 2;
+        const int my = visible.height() / 2;
+        m_vectorRenderer->request(size(), visible.adjusted(-mx, -my, mx, my));
+    }
+
+    if (raster) {
+        painter.drawImage(raster->area.topLeft(), raster->image);
+    }
+}
@@ -0,0 +1,80 @@
+#ifndef IMAGECANVAS_H
+#define IMAGECANVAS_H
+
+#include <QWidget>
+#include <QBrush>
+#include <QPixmap>
+#include "imagepyramid.h"
+#include "memorybudget.h"
+
+class VectorRenderer;
+
+// Widget placed inside the tab's scroll area. It is sized to the zoomed image
+// but only ever paints the exposed part of itself, sampling from the image
+// pyramid level closest to the current scale. Nothing is rescaled up front,
+// so zoom changes cost one viewport worth of pixels.
+// The last settled frame is kept, so re-showing the tab (tab switches) is a
+// plain blit until size, scroll position or content change. Pan steps paint
+// only the strip scrolled in; the next full expose builds a new frame. With an
+// opaque background the canvas paints its whole rect itself, so overlays above
+// it cost a clipped blit of that frame.
+class ImageCanvas : public QWidget
+{
+    Q_OBJECT
+public:
+    explicit ImageCanvas(QWidget *parent = nullptr);
+
+    void setImage(const ImagePyramid &pyramid);
+    // Vector mode: sharp rasters come from the renderer, fallback is shown until they arrive
+    void setVectorSource(VectorRenderer *renderer, const ImagePyramid &fallback);
+    void setMessage(const QString &message);
+
+    // Painted under transparent pixels and cached with the frame
+    void setBackground(const QBrush &brush);
+    static QBrush checkerboard();
+
+    // While animating, once a frame blows the budget the rest of the animation
+    // uses unfiltered sampling; settling repaints it smooth
+    void setAnimating(bool animating, double frameBudgetMs = 0.0);
+    double lastPaintMs() const;
+    bool isFastPaint() const;
+
+    void dropFrameCache();
+    qint64 frameCacheBytes() const;
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+
+private:
+    void paintVector(QPainter &painter, const QRect &exposed);
+    void paintPyramid(QPainter &painter);
+    void paintContent(QPainter &painter, const QRect &exposed);
+
+    struct FrameKey {
+        QSize size;
+        QRect visible;
+        qint64 content = 0;
+        qint64 raster = 0;
+        bool operator==(const FrameKey &other) const {
+            return size == other.size && visible == other.visible
+                && content == other.content && raster == other.raster;
+        }
+    };
+
+    ImagePyramid m_pyramid;
+    VectorRenderer *m_vectorRenderer;
+    QString m_message;
+    QBrush m_background;
+
+    bool m_animating;
+    bool m_fastPaint;
+    double m_frameBudgetMs;
+    double m_lastPaintMs;
+
+    // Per-canvas render cache, counted in the global memory budget
+    QPixmap m_frame;
+    FrameKey m_frameKey;
+    MemoryCharge m_frameCharge;
+};
+
+#endif // IMAGECANVAS_H
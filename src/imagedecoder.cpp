@@ -0,0 +1,147 @@
+#include "imagedecoder.h"
+#include "ziparchive.h"
+#include <QBuffer>
+#include <QFile>
+#include <QFileInfo>
+#include <QImageReader>
+
+namespace {
+    // Reader downscales to at least this multiple of the target, the final
+    // smooth scale from there avoids the aliasing of decoder-side scaling
+    constexpr int DECODE_OVERSAMPLE = 2;
+}
+
+QStringList ImageDecoder::nameFilters()
+{
+    QStringList filters;
+    filters << "*.jpg" << "*.jpeg" << "*.png" << "*.bmp" << "*.webp" << "*.svg" << "*.svgz";
+    return filters;
+}
+
+bool ImageDecoder::open(QImageReader &reader, QBuffer &buffer, const QString &path)
+{
+    if (!ZipArchive::isVirtualPath(path)) {
+        reader.setFileName(path);
+        return true;
+    }
+
+    bool ok = false;
+    QByteArray data = ZipArchive::readMember(path, -1, &ok);
+    if (!ok) return false;
+    open(reader, buffer, path, data);
+    return true;
+}
+
+void ImageDecoder::open(QImageReader &reader, QBuffer &buffer, const QString &path, const QByteArray &data)
+{
+    buffer.setData(data);
+    buffer.open(QIODevice::ReadOnly);
+    // No file name to go by, the suffix is only a hint next to content sniffing
+    reader.setDevice(&buffer);
+    reader.setFormat(QFileInfo(path).suffix().toLower().toLatin1());
+}
+
+QByteArray ImageDecoder::readSource(const QString &path, bool *ok)
+{
+    if (ZipArchive::isVirtualPath(path)) return ZipArchive::readMember(path, -1, ok);
+
+    QFile file(path);
+    *ok = file.open(QIODevice::ReadOnly);
+    if (!*ok) return QByteArray();
+    return file.readAll();
+}
+
+QImage ImageDecoder::read(QImageReader &reader, DecodedImage::Error *error)
+{
+    reader.setAutoTransform(true);
+
+    // Stability Check
+    if (!reader.canRead()) {
+        *error = DecodedImage::CannotRead;
+        return QImage();
+    }
+
+    QImage img = reader.read();
+    *error = img.isNull() ? DecodedImage::Corrupted : DecodedImage::NoError;
+    return img;
+}
+
+DecodedImage ImageDecoder::decode(const QString &path)
+{
+    DecodedImage result;
+    result.path = path;
+
+    QBuffer buffer; // Outlives the reader using it
+    QImageReader reader;
+    if (!open(reader, buffer, path)) {
+        result.error = DecodedImage::CannotRead;
+        return result;
+    }
+    QImage img = read(reader, &result.error);
+    if (result.error == DecodedImage::NoError) {
+        result.pyramid = ImagePyramid(img);
+    }
+    return result;
+}
+
+QImage ImageDecoder::decodeToFit(const QString &path, const QSize &bound, DecodedImage::Error *error)
+{
+    QBuffer buffer; // Outlives the reader using it
+    QImageReader reader;
+    if (!open(reader, buffer, path)) {
+        *error = DecodedImage::CannotRead;
+        return QImage();
+    }
+    return readToFit(reader, bound, error);
+}
+
+DecodedImage ImageDecoder::decode(const QString &path, const QByteArray &data)
+{
+    DecodedImage result;
+    result.path = path;
+
+    QBuffer buffer;
+    QImageReader reader;
+    open(reader, buffer, path, data);
+    QImage img = read(reader, &result.error);
+    if (result.error == DecodedImage::NoError) {
+        result.pyramid = ImagePyramid(img);
+    }
+    return result;
+}
+
+QImage ImageDecoder::decodeToFit(const QString &path, const QByteArray &data, const QSize &bound, DecodedImage::Error *error)
+{
+    QBuffer buffer;
+    QImageReader reader;
+    open(reader, buffer, path, data);
+    return readToFit(reader, bound, error);
+}
+
+QImage ImageDecoder::readToFit(QImageReader &reader, const QSize &bound, DecodedImage::Error *error)
+{
+    QSize fullSize = reader.size();
+    if (fullSize.isValid() && bound.isValid()) {
+        // Orientation is applied after scaling, fit the stored (unrotated) size
+        QSize storedBound = bound;
+        if (reader.transformation() & QImageIOHandler::TransformationRotate90) storedBound.transpose();
+
+        QSize target = fullSize.scaled(storedBound, Qt::KeepAspectRatio);
+        QSize decodeSize = target * DECODE_OVERSAMPLE;
+        if (decodeSize.width() < fullSize.width() && decodeSize.height() < fullSize.height()) {
+            reader.setScaledSize(decodeSize);
+        } else if (reader.format().startsWith("svg") && target.width() > fullSize.width()) {
+            // Vector sources: render sharp at the target size instead of scaling up later
+            reader.setScaledSize(target);
+        }
+    }
+
+    QImage img = read(reader, error);
+    if (img.isNull() || !bound.isValid()) return img;
+
+    QSize fitted = img.size().scaled(bound, Qt::KeepAspectRatio);
+    if (fitted.width() < img.width()) {
+        img = img.scaled(fitted, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+    }
+    return img;
+}
@@ -0,0 +1,57 @@
+#ifndef IMAGEDECODER_H
+#define IMAGEDECODER_H
+
+#include <QSize>
+#include <QString>
+#include <QStringList>
+#include "imagepyramid.h"
+
+class QBuffer;
+class QImageReader;
+
+struct DecodedImage
+{
+    enum Error {
+        NoError,
+        CannotRead, // No reader for this file
+        Corrupted   // Reader found, pixel data broken
+    };
+
+    QString path;
+    ImagePyramid pyramid;
+    Error error = NoError;
+
+    bool isValid() const { return error == NoError && !pyramid.isNull(); }
+};
+
+// Decode step shared by the viewer and background jobs. Thread safe, runs on
+// scheduler workers; builds the pyramid right away so the GUI thread never
+// touches full resolution pixels.
+class ImageDecoder
+{
+public:
+    // Folder listing filters for everything we can open
+    static QStringList nameFilters();
+
+    static DecodedImage decode(const QString &path);
+    // Decodes straight to a size fitting bound (keeping aspect), letting the
+    // reader skip work where it can (JPEG DCT scaling, SVG renders at size)
+    static QImage decodeToFit(const QString &path, const QSize &bound, DecodedImage::Error *error);
+
+    // The same split in an I/O half and a CPU half, so scheduler tasks can
+    // hand their I/O slot back before decoding. readSource() returns the
+    // encoded bytes (archive members inflated); the decode overloads take
+    // them, path then only hints at the format.
+    static QByteArray readSource(const QString &path, bool *ok);
+    static DecodedImage decode(const QString &path, const QByteArray &data);
+    static QImage decodeToFit(const QString &path, const QByteArray &data, const QSize &bound, DecodedImage::Error *error);
+
+private:
+    // Files are read from disk, archive members are inflated into buffer first
+    static bool open(QImageReader &reader, QBuffer &buffer, const QString &path);
+    static void open(QImageReader &reader, QBuffer &buffer, const QString &path, const QByteArray &data);
+    static QImage read(QImageReader &reader, DecodedImage::Error *error);
+    static QImage readToFit(QImageReader &reader, const QSize &bound, DecodedImage::Error *error);
+};
+
+#endif // IMAGEDECODER_H
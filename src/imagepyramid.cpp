@@ -0,0 +1,77 @@
+#include "imagepyramid.h"
+
+namespace {
+    // Stop halving below this, small levels are not worth the memory
+    constexpr int MIN_LEVEL_SIDE = 256;
+}
+
+ImagePyramid::ImagePyramid()
+{
+}
+
+ImagePyramid::ImagePyramid(const QImage &image)
+{
+    if (image.isNull()) return;
+
+    // Premultiplied / RGB32 are the formats the raster paint engine blits without conversion
+    QImage base = image.hasAlphaChannel()
+        ? image.convertToFormat(QImage::Format_ARGB32_Premultiplied)
+        : image.convertToFormat(QImage::Format_RGB32);
+    m_levels.append(base);
+
+    QImage current = base;
+    while (current.width() / 2 >= MIN_LEVEL_SIDE && current.height() / 2 >= MIN_LEVEL_SIDE) {
+        current = current.scaled(current.width() / 2, current.height() / 2,
+                                 Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+        m_levels.append(current);
+    }
+}
+
+bool ImagePyramid::isNull() const
+{
+    return m_levels.isEmpty();
+}
+
+QSize ImagePyramid::size() const
+{
+    return m_levels.isEmpty() ? QSize() : m_levels.first().size();
+}
+
+const QImage &ImagePyramid::base() const
+{
+    static const QImage empty;
+    return m_levels.isEmpty() ? empty : m_levels.first();
+}
+
+int ImagePyramid::levelCount() const
+{
+    return m_levels.size();
+}
+
+qint64 ImagePyramid::byteCount() const
+{
+    qint64 bytes = 0;
+    for (const QImage &level : m_levels) {
+        bytes += level.sizeInBytes();
+    }
+    return bytes;
+}
+
+const QImage &ImagePyramid::level(int index) const
+{
+    if (m_levels.isEmpty()) return base();
+    return m_levels.at(qBound(0, index, int(m_levels.size()) - 1));
+}
+
+const QImage &ImagePyramid::levelFor(double scale) const
+{
+    if (m_levels.isEmpty()) return base();
+
+    const double needed = m_levels.first().width() * scale;
+    for (int i = m_levels.size() - 1; i > 0; --i) {
+        if (m_levels.at(i).width() >= needed) {
+            return m_levels.at(i);
+        }
+    }
+    return m_levels.first();
+}
@@ -0,0 +1,30 @@
+#ifndef IMAGEPYRAMID_H
+#define IMAGEPYRAMID_H
+
+#include <QImage>
+#include <QVector>
+
+// Decoded image plus successively halved copies of it. Painting picks the
+// smallest level that still has enough pixels for the requested scale, so
+// the per-frame cost depends on the viewport size and not on the source size.
+class ImagePyramid
+{
+public:
+    ImagePyramid();
+    explicit ImagePyramid(const QImage &image);
+
+    bool isNull() const;
+    QSize size() const; // Full resolution size
+    const QImage &base() const;
+    int levelCount() const;
+    qint64 byteCount() const;
+    const QImage &level(int index) const;
+
+    // Smallest level with at least `scale` times the full resolution
+    const QImage &levelFor(double scale) const;
+
+private:
+    QVector<QImage> m_levels;
+};
+
+#endif // IMAGEPYRAMID_H
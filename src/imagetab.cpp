@@ -1,5 +1,17 @@
 #include "imagetab.h"
-#include <QLabel>
+#include "imagecache.h"
+#include "imagecanvas.h"
+#include "folderwatcher.h"
+#include "histogram.h"
+#include "histogramoverlay.h"
+#include "imagepyramid.h"
+#include "metadataindex.h"
+#include "overlaylayer.h"
+#include "pixelloupe.h"
+#include "similarityindex.h"
+#include "vectorrenderer.h"
+#include "ziparchive.h"
+#include "zoommath.h"
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QPushButton>
@@ -8,59 +20,95 @@
 #include <QWheelEvent>
 #include <QScrollArea>
 #include <QScrollBar>
-#include <QImageReader>
 #include <QApplication>
+#include <QClipboard>
 #include <QEvent>
 #include <QCursor>
-#include <QPainter>
-#include <QPushButton>
-#include <QHBoxLayout>
+#include <QNativeGestureEvent>
+#include <QScreen>
+#include <QSet>
+#include <QTimer>
 #include <algorithm>
+#include <cmath>
 
 namespace {
-    constexpr double MIN_ZOOM = 0.1;
-    constexpr double MAX_ZOOM = 5.0;
-    constexpr double ZOOM_STEP = 0.1;
+    constexpr int ZOOM_ANIMATION_MS = 160;
+    // Images decoded ahead on each side of the current one
+    constexpr int PREFETCH_AHEAD = 2;
+    constexpr int PREFETCH_BEHIND = 1;
+
+    QString sortModeName(ImageTab::SortMode mode)
+    {
+        switch (mode) {
+        case ImageTab::SortByDate: return "Date";
+        case ImageTab::SortBySize: return "Size";
+        case ImageTab::SortByDimensions: return "Dimensions";
+        case ImageTab::SortByName: break;
+        }
+        return "Name";
+    }
 }
 
-ImageTab::ImageTab(const QString &filePath, QWidget *parent)
+ImageTab::ImageTab(const QString &filePath, QWidget *parent, LoadMode mode)
     : QWidget(parent)
     , m_currentFilePath(filePath)
-    , m_imageLabel(new QLabel) // Parent handled by setWidget
+    , m_materialized(false)
+    , m_hasPendingView(false)
+    , m_canvas(new ImageCanvas) // Parent handled by setWidget
     , m_scrollArea(new QScrollArea(this))
+    , m_vectorRenderer(new VectorRenderer(this))
+    , m_isVector(false)
+    , m_loadGeneration(0)
+    , m_histogram(new Histogram(this))
+    , m_overlay(nullptr)
+    , m_hudPanel(nullptr)
+    , m_histogramOverlay(nullptr)
+    , m_loupe(nullptr)
+    , m_loupeEnabled(false)
+    , m_metadataIndex(new MetadataIndex(this))
+    , m_sortMode(SortByName)
+    , m_similarityIndex(new SimilarityIndex(this))
+    , m_bestOfBurstOnly(false)
+    , m_folderWatcher(nullptr)
+    , m_autoAdvance(false)
     , m_currentIndex(-1)
+    , m_currentRemoved(false)
     , m_loadSuccess(false)
     , m_zoomFactor(1.0)
+    , m_displayedZoom(0.0)
+    , m_zoomTimer(new QTimer(this))
+    , m_zoomFrom(1.0)
+    , m_zoomTo(1.0)
     , m_isDragging(false)
 {
     QVBoxLayout *mainLayout = new QVBoxLayout(this);
     mainLayout->setContentsMargins(0, 0, 0, 0);
 
-    // Image Area (Label)
-    m_imageLabel->setAlignment(Qt::AlignCenter);
-    m_imageLabel->setSizePolicy(QSizePolicy::Ignored, QSizePolicy::Ignored);
+    // Image Area (Canvas)
+    m_canvas->setSizePolicy(QSizePolicy::Ignored, QSizePolicy::Ignored);
     // Install event filter to capture mouse events for dragging
-    m_imageLabel->installEventFilter(this);
+    m_canvas->installEventFilter(this);
     
     // Scroll Area
     // Layout and UI
-    m_scrollArea->setWidget(m_imageLabel);
+    m_scrollArea->setWidget(m_canvas);
     m_scrollArea->setWidgetResizable(false); 
     m_scrollArea->setAlignment(Qt::AlignCenter);
     
     // Checkerboard Background for transparency
-    // Programmatic texture pattern
-    QPixmap checker(20, 20);
-    checker.fill(QColor(60, 60, 60));
-    QPainter p(&checker);
-    p.fillRect(0, 0, 10, 10, QColor(45, 45, 45));
-    p.fillRect(10, 10, 10, 10, QColor(45, 45, 45));
-    p.end();
+    // The canvas paints (and caches) it under the image, the viewport only around it
+    m_canvas->setBackground(ImageCanvas::checkerboard());
     QPalette pal = m_scrollArea->palette(); // Apply to scroll area's viewport
-    pal.setBrush(QPalette::Window, QBrush(checker));
+    pal.setBrush(QPalette::Window, ImageCanvas::checkerboard());
     m_scrollArea->viewport()->setPalette(pal);
     m_scrollArea->viewport()->setBackgroundRole(QPalette::Window);
     m_scrollArea->viewport()->setAutoFillBackground(true);
+    // Ctrl+Wheel and pinch gestures zoom even when the scroll area could scroll
+    m_scrollArea->viewport()->installEventFilter(this);
+
+    // Zoom animation, ticks once per display refresh while running
+    m_zoomTimer->setTimerType(Qt::PreciseTimer);
+    connect(m_zoomTimer, &QTimer::timeout, this, &ImageTab::onZoomFrame);
     
     // Focus policy for key events
     setFocusPolicy(Qt::StrongFocus);
@@ -78,11 +126,88 @@ ImageTab::ImageTab(const QString &filePath, QWidget *parent)
 
     mainLayout->addWidget(m_scrollArea, 1);
 
-    // Initial setup
-    scanFolder(); 
-    // We defer heavy rendering to showEvent or initial load, but loadImage sets up state.
-    loadImage(m_currentFilePath);
+    // Sorting by anything but name waits for the header index, and so does hashing:
+    // both read every file, and headers are what the status and sort need first
+    connect(m_metadataIndex, &MetadataIndex::ready, this, [this]() {
+        if (!m_hashFolder.isEmpty()) {
+            QFileInfoList list;
+            list.reserve(m_nameOrder.size());
+            for (const QString &path : std::as_const(m_nameOrder)) {
+                list.append(QFileInfo(path));
+            }
+            m_similarityIndex->index(m_hashFolder, list);
+            m_hashFolder.clear();
+        }
+        if (m_sortMode != SortByName) applySortMode();
+        if (isVisible()) reportStatus();
+    });
+    connect(m_similarityIndex, &SimilarityIndex::progress, this, [this]() {
+        if (isVisible()) reportStatus();
+    });
+    connect(m_similarityIndex, &SimilarityIndex::ready, this, [this]() {
+        m_bursts.clear();
+        if (isVisible()) reportStatus();
+    });
+
     setupHud();
+
+    // Initial setup. Restored session tabs wait for their first showEvent.
+    if (mode == LoadNow) {
+        materialize();
+    }
+}
+
+ImageTab::~ImageTab()
+{
+    releasePendingDecode();
+    for (const QString &path : std::as_const(m_prefetchPaths)) {
+        ImageCache::instance()->cancelPrefetch(path);
+    }
+}
+
+void ImageTab::materialize()
+{
+    m_materialized = true;
+    scanFolder();
+    loadImage(m_currentFilePath);
+}
+
+Session::Tab ImageTab::viewState() const
+{
+    // Never shown since the restore (or still decoding): hand back what we were given
+    if (m_hasPendingView) return m_pendingView;
+
+    Session::Tab state;
+    state.filePath = m_currentFilePath;
+    state.zoom = m_zoomFactor;
+    if (m_canvas->width() > 0 && m_canvas->height() > 0) {
+        QWidget *viewport = m_scrollArea->viewport();
+        QPointF center = m_canvas->mapFrom(viewport, viewport->rect().center());
+        state.center = QPointF(qBound(0.0, center.x() / m_canvas->width(), 1.0),
+                               qBound(0.0, center.y() / m_canvas->height(), 1.0));
+    }
+    return state;
+}
+
+void ImageTab::restoreViewState(const Session::Tab &state)
+{
+    m_pendingView = state;
+    m_hasPendingView = true;
+    applyPendingView(); // Only does something if the image is already up
+}
+
+void ImageTab::applyPendingView()
+{
+    if (!m_hasPendingView || !m_loadSuccess || m_pendingView.filePath != m_currentFilePath) return;
+    QWidget *viewport = m_scrollArea->viewport();
+    if (viewport->size().isEmpty()) return; // Not laid out yet, showEvent comes back here
+
+    m_hasPendingView = false;
+    stopZoomAnimation();
+    m_zoomFactor = qBound(ZoomMath::MIN_ZOOM, m_pendingView.zoom, maxZoom());
+    updateImageDisplay();
+    m_scrollArea->horizontalScrollBar()->setValue(qRound(m_pendingView.center.x() * m_canvas->width() - viewport->width() / 2.0));
+    m_scrollArea->verticalScrollBar()->setValue(qRound(m_pendingView.center.y() * m_canvas->height() - viewport->height() / 2.0));
 }
 
 QString ImageTab::currentFilePath() const
@@ -90,17 +215,41 @@ QString ImageTab::currentFilePath() const
     return m_currentFilePath;
 }
 
+QStringList ImageTab::imageList() const
+{
+    return m_images;
+}
+
+int ImageTab::currentIndex() const
+{
+    return m_currentIndex;
+}
+
+double ImageTab::zoomFactor() const
+{
+    return m_zoomFactor;
+}
+
+bool ImageTab::isImageLoaded() const
+{
+    return m_loadSuccess;
+}
+
 void ImageTab::setupHud()
 {
+    // Below the HUD buttons, above the scroll area
+    m_overlay = new OverlayLayer(this);
+    m_overlay->setGeometry(rect());
+
     m_hudWidget = new QWidget(this);
     QHBoxLayout *layout = new QHBoxLayout(m_hudWidget);
     layout->setContentsMargins(10, 5, 10, 5);
     layout->setSpacing(10);
     
     // Style HUD
-    // Semi-transparent black pill
+    // Semi-transparent black pill, drawn by the overlay layer so the buttons
+    // are the only stylesheet widgets left over the image
     m_hudWidget->setStyleSheet(
-        "QWidget { background-color: rgba(0, 0, 0, 150); border-radius: 20px; }"
         "QPushButton { background: transparent; border: none; color: white; font-weight: bold; font-size: 14px; }"
         "QPushButton:hover { color: #4a90e2; }"
     );
@@ -121,6 +270,17 @@ void ImageTab::setupHud()
     
     m_hudWidget->adjustSize();
     m_hudWidget->hide(); // Hidden by default, shown on hover
+
+    // Stacking follows the order items are added
+    m_hudPanel = new OverlayPanel(QColor(0, 0, 0, 150), 20, this);
+    m_overlay->addItem(m_hudPanel);
+
+    m_histogramOverlay = new HistogramOverlay(m_histogram, this);
+    m_overlay->addItem(m_histogramOverlay);
+
+    m_loupe = new PixelLoupe(this);
+    m_loupe->setSource(m_pyramid.base());
+    m_overlay->addItem(m_loupe);
 }
 
 void ImageTab::updateHudPosition()
@@ -130,12 +290,19 @@ void ImageTab::updateHudPosition()
         int x = (width() - m_hudWidget->width()) / 2;
         int y = height() - m_hudWidget->height() - 20;
         m_hudWidget->move(x, y);
+        m_overlay->setItemGeometry(m_hudPanel, m_hudWidget->geometry());
+    }
+    if (m_histogramOverlay) {
+        // Floating top right
+        QRect histogramRect = m_overlay->itemGeometry(m_histogramOverlay);
+        m_overlay->moveItem(m_histogramOverlay, QPoint(width() - histogramRect.width() - 20, 20));
     }
 }
 
 void ImageTab::resizeEvent(QResizeEvent *event)
 {
     QWidget::resizeEvent(event);
+    m_overlay->setGeometry(rect());
     updateHudPosition();
     if (m_loadSuccess) {
         if (qAbs(m_zoomFactor - 1.0) < 0.01) {
@@ -146,7 +313,10 @@ void ImageTab::resizeEvent(QResizeEvent *event)
 
 // Events for HUD visibility
 void ImageTab::enterEvent(QEnterEvent *event) {
-    if (m_hudWidget) m_hudWidget->show();
+    if (m_hudWidget) {
+        m_hudWidget->show();
+        m_overlay->setItemVisible(m_hudPanel, true);
+    }
     QWidget::enterEvent(event);
 }
 
@@ -154,7 +324,10 @@ void ImageTab::leaveEvent(QEvent *event) {
     // Only hide if we aren't hovering the HUD itself (which is a child, so effectively we don't leave?)
     // Actually, mouse tracking might be needed for perfect behavior, or check rect.
     // Simple approach: Hide on leave. 
-    if (m_hudWidget && !m_hudWidget->underMouse()) m_hudWidget->hide();
+    if (m_hudWidget && !m_hudWidget->underMouse()) {
+        m_hudWidget->hide();
+        m_overlay->setItemVisible(m_hudPanel, false);
+    }
     QWidget::leaveEvent(event);
 }
 
@@ -163,20 +336,72 @@ void ImageTab::showEvent(QShowEvent *event)
     QWidget::showEvent(event);
     // Ensure we have focus for keyboard shortcuts
     this->setFocus();
+    if (!m_materialized) {
+        materialize();
+    }
+    updateDecodePriorities();
+    applyPendingView();
     
     if (m_loadSuccess) {
-        updateImageDisplay();
+        // Nothing changed while hidden: the canvas blits its cached frame
+        if (m_scrollArea->viewport()->size() == m_displayedViewport && m_zoomFactor == m_displayedZoom) {
+            reportStatus();
+        } else {
+            updateImageDisplay();
+        }
     }
     updateHudPosition();
 }
 
+void ImageTab::hideEvent(QHideEvent *event)
+{
+    QWidget::hideEvent(event);
+    updateDecodePriorities();
+}
+
 void ImageTab::keyPressEvent(QKeyEvent *event)
 {
     if (event->key() == Qt::Key_Left) {
         showPreviousImage();
     } else if (event->key() == Qt::Key_Right) {
         showNextImage();
+    } else if (event->key() == Qt::Key_PageDown) {
+        showBurst(1);
+    } else if (event->key() == Qt::Key_PageUp) {
+        showBurst(-1);
+    } else if (event->key() == Qt::Key_B) {
+        setBestOfBurstOnly(!m_bestOfBurstOnly);
+    } else if (event->key() == Qt::Key_S) {
+        cycleSortMode();
+    } else if (event->key() == Qt::Key_H) {
+        setHistogramVisible(!m_overlay->isItemVisible(m_histogramOverlay));
+    } else if (event->key() == Qt::Key_M) {
+        setLoupeEnabled(!m_loupeEnabled);
+    } else if (m_loupeEnabled && (event->key() == Qt::Key_BracketLeft || event->key() == Qt::Key_BracketRight)) {
+        // Powers of two between 1x and 16x
+        int magnification = m_loupe->magnification();
+        magnification = event->key() == Qt::Key_BracketRight ? magnification * 2 : magnification / 2;
+        m_loupe->setMagnification(magnification);
+    } else if (event->key() == Qt::Key_C && m_loupeEnabled && m_loupe->hasPixel()) {
+        QApplication::clipboard()->setText(m_loupe->color().name(QColor::HexRgb).toUpper());
+        emit statusChanged(QString("Copied %1 at %2, %3")
+            .arg(m_loupe->color().name(QColor::HexRgb).toUpper())
+            .arg(m_loupe->pixel().x()).arg(m_loupe->pixel().y()));
+    } else if (event->key() == Qt::Key_L && (event->modifiers() & Qt::ShiftModifier)) {
+        m_autoAdvance = !m_autoAdvance;
+        if (m_autoAdvance && !m_folderWatcher) setLiveMode(true);
+        reportStatus();
+    } else if (event->key() == Qt::Key_L) {
+        setLiveMode(!m_folderWatcher);
+    } else if (event->key() >= Qt::Key_2 && event->key() <= Qt::Key_4 && m_images.size() >= 2) {
+        // Start at the current image, shifted back when it is near the end of the folder
+        int count = qMin(event->key() - Qt::Key_0, int(m_images.size()));
+        int first = qBound(0, m_currentIndex, int(m_images.size()) - count);
+        QList<int> shown;
+        for (int i = 0; i < count; ++i) shown << first + i;
+        emit compareRequested(m_images, shown);
     } else if (event->key() == Qt::Key_Escape) {
+        stopZoomAnimation();
         m_zoomFactor = 1.0;
         updateImageDisplay();
     } else {
@@ -189,13 +414,13 @@ void ImageTab::mouseDoubleClickEvent(QMouseEvent *event)
     if (!m_loadSuccess) return;
     
     // Toggle Zoom
-    // If we are close to Fit (1.0), zoom to Actual (1.0001)
+    // If we are close to Fit (1.0), zoom to Actual, keeping the clicked point in place
     // If we are anything else, zoom to Fit (1.0)
-    
+    QPoint anchor = m_scrollArea->viewport()->mapFrom(this, event->position().toPoint());
     if (qAbs(m_zoomFactor - 1.0) < 0.001) {
-        zoomActualSize();
+        animateZoomTo(actualSizeFactor(), anchor);
     } else {
-        resetZoom();
+        animateZoomTo(1.0, anchor);
     }
     event->accept();
 }
@@ -207,23 +432,43 @@ void ImageTab::wheelEvent(QWheelEvent *event)
         return;
     }
 
-    if (event->angleDelta().y() > 0) {
-        m_zoomFactor += ZOOM_STEP;
-    } else if (event->angleDelta().y() < 0) {
-        m_zoomFactor -= ZOOM_STEP;
-    }
-
-    // Clamp zoom factor
-    if (m_zoomFactor < MIN_ZOOM) m_zoomFactor = MIN_ZOOM;
-    if (m_zoomFactor > MAX_ZOOM) m_zoomFactor = MAX_ZOOM;
-
-    updateImageDisplay();
+    zoomByWheel(event, m_scrollArea->viewport()->mapFrom(this, event->position().toPoint()));
     event->accept();
 }
 
+void ImageTab::zoomByWheel(const QWheelEvent *event, const QPoint &anchor)
+{
+    if (ZoomMath::isTouchpad(event)) {
+        // Touchpads already deliver a smooth stream of small deltas, follow them directly
+        stopZoomAnimation();
+        applyZoom(m_zoomFactor * ZoomMath::wheelFactor(event), anchor);
+    } else if (event->angleDelta().y() != 0) {
+        // Notches accumulate onto the running animation's target
+        double base = m_zoomTimer->isActive() ? m_zoomTo : m_zoomFactor;
+        animateZoomTo(base * ZoomMath::wheelFactor(event), anchor);
+    }
+}
+
 bool ImageTab::eventFilter(QObject *watched, QEvent *event)
 {
-    if (watched == m_imageLabel && m_loadSuccess) {
+    if (watched == m_scrollArea->viewport() && m_loadSuccess) {
+        if (event->type() == QEvent::Wheel) {
+            QWheelEvent *wheel = static_cast<QWheelEvent*>(event);
+            if (wheel->modifiers() & Qt::ControlModifier) {
+                zoomByWheel(wheel, wheel->position().toPoint());
+                return true;
+            }
+        } else if (event->type() == QEvent::NativeGesture) {
+            QNativeGestureEvent *gesture = static_cast<QNativeGestureEvent*>(event);
+            if (gesture->gestureType() == Qt::ZoomNativeGesture) {
+                stopZoomAnimation();
+                applyZoom(m_zoomFactor * (1.0 + gesture->value()), gesture->position().toPoint());
+                return true;
+            }
+        }
+    }
+
+    if (watched == m_canvas && m_loadSuccess) {
         if (event->type() == QEvent::MouseButtonPress) {
             QMouseEvent *mouseEvent = static_cast<QMouseEvent*>(event);
             if (mouseEvent->button() == Qt::LeftButton && m_zoomFactor > 1.0) {
@@ -233,17 +478,22 @@ bool ImageTab::eventFilter(QObject *watched, QEvent *event)
                 return true; // Consume event
             }
         } else if (event->type() == QEvent::MouseMove) {
+            QMouseEvent *mouseEvent = static_cast<QMouseEvent*>(event);
             if (m_isDragging) {
-                QMouseEvent *mouseEvent = static_cast<QMouseEvent*>(event);
                 QPoint delta = mouseEvent->globalPosition().toPoint() - m_lastMousePos;
                 m_lastMousePos = mouseEvent->globalPosition().toPoint();
 
                 // Move scrollBars
                 m_scrollArea->horizontalScrollBar()->setValue(m_scrollArea->horizontalScrollBar()->value() - delta.x());
                 m_scrollArea->verticalScrollBar()->setValue(m_scrollArea->verticalScrollBar()->value() - delta.y());
-                
-                return true;
             }
+            if (m_loupeEnabled) {
+                // Canvas may just have scrolled under the cursor
+                updateLoupe(m_canvas->mapFromGlobal(mouseEvent->globalPosition().toPoint()));
+            }
+            if (m_isDragging) return true;
+        } else if (event->type() == QEvent::Leave) {
+            m_overlay->setItemVisible(m_loupe, false);
         } else if (event->type() == QEvent::MouseButtonRelease) {
             if (m_isDragging) {
                 m_isDragging = false;
@@ -255,107 +505,591 @@ bool ImageTab::eventFilter(QObject *watched, QEvent *event)
     return QWidget::eventFilter(watched, event);
 }
 
+bool ImageTab::isSupportedFile(const QString &path)
+{
+    const QString name = QFileInfo(path).fileName();
+    for (const QString &filter : ImageDecoder::nameFilters()) {
+        if (name.endsWith(filter.mid(1), Qt::CaseInsensitive)) return true;
+    }
+    return false;
+}
+
 void ImageTab::scanFolder()
 {
-    QFileInfo fileInfo(m_currentFilePath);
-    QDir dir = fileInfo.dir();
-    
-    QStringList filters;
-    filters << "*.jpg" << "*.jpeg" << "*.png" << "*.bmp" << "*.webp";
-    dir.setNameFilters(filters);
-    
-    QFileInfoList list = dir.entryInfoList(QDir::Files | QDir::NoDotAndDotDot, QDir::Name);
+    QString archivePath;
+    if (ZipArchive::isArchiveFile(m_currentFilePath) && QFileInfo(m_currentFilePath).isFile()) {
+        archivePath = m_currentFilePath; // The archive itself was opened
+    } else {
+        ZipArchive::splitVirtualPath(m_currentFilePath, &archivePath, nullptr);
+    }
+
+    QString folder;
+    QFileInfoList list;
+    if (!archivePath.isEmpty()) {
+        // Archives browse like one folder holding all their images, subfolders flattened
+        folder = QFileInfo(archivePath).absoluteFilePath();
+        const QStringList members = ZipArchive::imagePaths(folder);
+        list.reserve(members.size());
+        for (const QString &path : members) {
+            list.append(QFileInfo(path));
+        }
+        if (m_currentFilePath == archivePath) m_currentFilePath = members.value(0);
+    } else {
+        QDir dir = QFileInfo(m_currentFilePath).dir();
+        dir.setNameFilters(ImageDecoder::nameFilters());
+        list = dir.entryInfoList(QDir::Files | QDir::NoDotAndDotDot, QDir::Name);
+        folder = dir.absolutePath();
+    }
     
     m_images.clear();
+    m_images.reserve(list.size());
     for (const QFileInfo &info : list) {
         m_images.append(info.absoluteFilePath());
     }
+    m_nameOrder = m_images;
     
     m_currentIndex = m_images.indexOf(QFileInfo(m_currentFilePath).absoluteFilePath());
+    m_currentRemoved = false;
+
+    // Headers and EXIF for the whole folder, then perceptual hashes, in the background
+    m_bursts.clear();
+    m_similarityIndex->clear();
+    m_hashFolder = folder;
+    m_metadataIndex->index(folder, list);
+}
+
+void ImageTab::setLiveMode(bool enabled)
+{
+    if (enabled && ZipArchive::isVirtualPath(m_currentFilePath)) {
+        emit statusChanged("Live mode is not available inside archives");
+        return;
+    }
+
+    delete m_folderWatcher;
+    m_folderWatcher = nullptr;
+
+    if (enabled) {
+        m_folderWatcher = new FolderWatcher(QFileInfo(m_currentFilePath).absolutePath(), this);
+        connect(m_folderWatcher, &FolderWatcher::filesReady, this, &ImageTab::onFilesReady);
+        connect(m_folderWatcher, &FolderWatcher::filesRemoved, this, &ImageTab::onFilesRemoved);
+        connect(m_folderWatcher, &FolderWatcher::overflowed, this, [this]() {
+            // Lost events, one full rescan gets us back in sync
+            scanFolder();
+            applySortMode();
+            reportStatus();
+        });
+    } else {
+        m_autoAdvance = false;
+    }
+    reportStatus();
+}
+
+int ImageTab::nameOrderPosition(const QString &path) const
+{
+    // m_nameOrder is kept sorted the way QDir::Name lists it
+    auto it = std::lower_bound(m_nameOrder.constBegin(), m_nameOrder.constEnd(), path,
+        [](const QString &a, const QString &b) { return QString::compare(a, b) < 0; });
+    return int(it - m_nameOrder.constBegin());
+}
+
+void ImageTab::onFilesReady(const QStringList &paths)
+{
+    QString newest;
+    QFileInfoList changed;
+    for (const QString &path : paths) {
+        if (!isSupportedFile(path)) continue;
+
+        int position = nameOrderPosition(path);
+        if (position < m_nameOrder.size() && m_nameOrder.at(position) == path) {
+            // Rewritten in place
+            ImageCache::instance()->invalidate(path);
+            if (path == QFileInfo(m_currentFilePath).absoluteFilePath() && !m_autoAdvance) {
+                loadImage(path);
+            }
+        } else {
+            m_nameOrder.insert(position, path);
+            // Deleted and written again, the way some editors save: on screen again
+            const bool returned = m_currentRemoved && path == QFileInfo(m_currentFilePath).absoluteFilePath();
+            if (m_sortMode == SortByName) {
+                m_images.insert(position, path);
+                // A file landing in the slot of a deleted current one comes after it
+                if (position < m_currentIndex || (position == m_currentIndex && !m_currentRemoved)) m_currentIndex++;
+            } else {
+                // Until its metadata is read; a new capture is the newest, so the end is
+                // right for date order, and the re-sort on ready() places it for the others
+                m_images.append(path);
+                if (returned) m_currentIndex = int(m_images.size()) - 1;
+            }
+            if (returned) {
+                m_currentRemoved = false;
+                if (!m_autoAdvance) loadImage(path);
+            }
+        }
+        changed.append(QFileInfo(path));
+        newest = path;
+    }
+    // Only the new files are read and hashed; each index emits ready() when merged
+    m_metadataIndex->update(changed, QStringList());
+    m_similarityIndex->update(changed, QStringList());
+    m_bursts.clear(); // New files are bursts of their own until their hashes are in
+
+    if (m_autoAdvance && !newest.isEmpty()) {
+        m_currentIndex = m_images.indexOf(newest);
+        loadImage(newest);
+    } else if (!newest.isEmpty()) {
+        prefetchNeighbors();
+        reportStatus();
+    }
+}
+
+void ImageTab::onFilesRemoved(const QStringList &paths)
+{
+    QSet<QString> removed;
+    removed.reserve(paths.size());
+    for (const QString &path : paths) {
+        ImageCache::instance()->invalidate(path);
+        removed.insert(path);
+    }
+    auto isRemoved = [&removed](const QString &path) { return removed.contains(path); };
+
+    // One pass over each list whatever the sort order, so a batch of deletions
+    // costs the same as one
+    m_nameOrder.erase(std::remove_if(m_nameOrder.begin(), m_nameOrder.end(), isRemoved), m_nameOrder.end());
+
+    // Shift the current position by the deletions before it. The one on screen
+    // stays until we move, its successor takes its slot: Next goes there, Previous
+    // to the one before.
+    int kept = 0;
+    int current = m_currentIndex;
+    for (int i = 0; i < m_images.size(); ++i) {
+        if (i == m_currentIndex) current = kept;
+        if (!isRemoved(m_images.at(i))) m_images[kept++] = m_images.at(i);
+    }
+    if (m_currentIndex >= m_images.size()) current = kept;
+    m_images.resize(kept);
+    m_currentIndex = current;
+    m_currentRemoved = m_currentRemoved || removed.contains(QFileInfo(m_currentFilePath).absoluteFilePath());
+    m_metadataIndex->update(QFileInfoList(), paths);
+    m_similarityIndex->update(QFileInfoList(), paths);
+    m_bursts.clear();
+    reportStatus();
+}
+
+void ImageTab::applySortMode()
+{
+    if (m_sortMode == SortByName || !m_metadataIndex->isReady()) {
+        m_images = m_nameOrder;
+    } else {
+        // Look keys up once, 100k hash lookups per comparison would dominate
+        QVector<QPair<qint64, int>> keys;
+        keys.reserve(m_nameOrder.size());
+        for (int i = 0; i < m_nameOrder.size(); ++i) {
+            ImageMetadata meta = m_metadataIndex->metadata(m_nameOrder.at(i));
+            qint64 key = 0;
+            if (m_sortMode == SortByDate) {
+                key = meta.captureTime.isValid() ? meta.captureTime.toMSecsSinceEpoch() : 0;
+            } else if (m_sortMode == SortBySize) {
+                key = meta.fileSize;
+            } else {
+                key = qint64(meta.size.width()) * meta.size.height();
+            }
+            keys.append(qMakePair(key, i));
+        }
+        // Pairs compare by key, then name position, so ties keep name order
+        std::sort(keys.begin(), keys.end());
+
+        m_images.clear();
+        m_images.reserve(keys.size());
+        for (const auto &entry : keys) {
+            m_images.append(m_nameOrder.at(entry.second));
+        }
+    }
+
+    if (m_currentRemoved) {
+        // Still gone: keep its slot, only new files can have moved since
+        m_currentIndex = qMin(m_currentIndex, int(m_images.size()));
+    } else {
+        m_currentIndex = m_images.indexOf(QFileInfo(m_currentFilePath).absoluteFilePath());
+    }
+    m_bursts.clear();
+}
+
+void ImageTab::cycleSortMode()
+{
+    m_sortMode = SortMode((m_sortMode + 1) % SortModeCount);
+    applySortMode();
+    reportStatus();
 }
 
 void ImageTab::loadImage(const QString &path)
 {
+    if (m_hasPendingView && path != m_pendingView.filePath) m_hasPendingView = false;
     m_currentFilePath = path;
+    m_currentRemoved = false;
+    stopZoomAnimation();
     m_zoomFactor = 1.0; 
     
     m_loadSuccess = false; // Initialize to false, set to true only on success
+    m_isVector = false;
+    m_displayedViewport = QSize();
+    m_pyramid = ImagePyramid();
+    reportStatus(); // Metadata, if indexed, is there before the pixels
+    m_vectorRenderer->clear();
+    m_histogram->clear();
+    if (m_loupe) m_loupe->setSource(QImage()); // Don't pin the previous buffer
 
-    QImageReader reader(path);
-    reader.setAutoTransform(true);
-    
-    // Stability Check
-    if (!reader.canRead()) {
-        m_imageLabel->setText("Error: Cannot load image.\n" + path);
-        m_imageLabel->adjustSize();
-        emit statusChanged("Error: Failed to load image");
-        m_imageLabel->setCursor(Qt::ArrowCursor); // Ensure cursor is default on error
+    // Vectors are rendered per zoom level by VectorRenderer, the intrinsic
+    // size raster only serves as a placeholder and for the status bar.
+    if (VectorRenderer::isVectorFile(path)) {
+        m_loadGeneration++;
+        releasePendingDecode();
+        if (!m_vectorRenderer->load(path)) {
+            m_canvas->setMessage("Error: Cannot load image.\n" + path);
+            emit statusChanged("Error: Failed to load image");
+            m_canvas->setCursor(Qt::ArrowCursor);
+            emit imageLoaded(path);
+            return;
+        }
+        m_isVector = true;
+        m_pyramid = ImagePyramid(m_vectorRenderer->renderDefault());
+        m_canvas->setVectorSource(m_vectorRenderer, m_pyramid);
+        m_loadSuccess = true;
+
+        updateImageDisplay();
+        prefetchNeighbors();
+        refreshHistogram();
+        if (m_loupe) m_loupe->setSource(m_pyramid.base());
+        applyPendingView();
+        emit imageLoaded(path);
         return;
     }
 
-    QImage img = reader.read();
-    if (img.isNull()) {
-        m_imageLabel->setText("Error: Image data corrupted.\n" + path);
-        m_imageLabel->adjustSize();
+    // Decoded on a scheduler worker. The previous image stays on the canvas
+    // until this one arrives; prefetched neighbors come back synchronously.
+    const int generation = ++m_loadGeneration;
+    releasePendingDecode();
+    m_pendingDecodePath = path;
+    ImageCache::instance()->request(path, currentPriority(TaskScheduler::Visible), this,
+        [this, generation](const DecodedImage &image) {
+            if (generation != m_loadGeneration) return;
+            m_pendingDecodePath.clear();
+            showDecodedImage(image);
+        });
+}
+
+void ImageTab::showDecodedImage(const DecodedImage &image)
+{
+    if (image.error == DecodedImage::CannotRead) {
+        m_canvas->setMessage("Error: Cannot load image.\n" + image.path);
+        emit statusChanged("Error: Failed to load image");
+        m_canvas->setCursor(Qt::ArrowCursor); // Ensure cursor is default on error
+        emit imageLoaded(image.path);
+        return;
+    }
+    if (!image.isValid()) {
+        m_canvas->setMessage("Error: Image data corrupted.\n" + image.path);
         emit statusChanged("Error: Image corrupted");
-        m_imageLabel->setCursor(Qt::ArrowCursor); // Ensure cursor is default on error
+        m_canvas->setCursor(Qt::ArrowCursor); // Ensure cursor is default on error
+        emit imageLoaded(image.path);
         return;
     }
     
-    m_originalPixmap = QPixmap::fromImage(img); // Use m_originalPixmap as per class member
-    m_imageLabel->setPixmap(m_originalPixmap);
+    m_pyramid = image.pyramid;
+    m_canvas->setImage(m_pyramid);
     m_loadSuccess = true;
-    m_imageLabel->adjustSize();
-    
-    // Initial display update
-    updateImageDisplay();
+    m_canvas->resize(m_pyramid.size());
     
     // Initial display update
     updateImageDisplay();
+    prefetchNeighbors();
+    refreshHistogram();
+    if (m_loupe) m_loupe->setSource(m_pyramid.base());
+    applyPendingView();
+    emit imageLoaded(image.path);
+}
+
+TaskScheduler::Priority ImageTab::currentPriority(TaskScheduler::Priority whenVisible) const
+{
+    // Tabs that are not on screen queue behind everything the visible one needs
+    return isVisible() ? whenVisible : TaskScheduler::HiddenTab;
+}
+
+void ImageTab::releasePendingDecode()
+{
+    if (!m_pendingDecodePath.isEmpty()) {
+        ImageCache::instance()->release(m_pendingDecodePath, this);
+        m_pendingDecodePath.clear();
+    }
+}
+
+void ImageTab::prefetchNeighbors()
+{
+    QStringList wanted;
+    // After a deletion the successor already sits at m_currentIndex
+    const int from = m_currentRemoved ? m_currentIndex - 1 : m_currentIndex;
+    for (int offset = 1; offset <= PREFETCH_AHEAD; ++offset) {
+        int index = from + offset;
+        if (index >= 0 && index < m_images.size()) wanted << m_images.at(index);
+    }
+    for (int offset = 1; offset <= PREFETCH_BEHIND; ++offset) {
+        int index = m_currentIndex - offset;
+        if (index >= 0 && index < m_images.size()) wanted << m_images.at(index);
+    }
+
+    // Drop the ones we moved away from before queueing new ones
+    for (const QString &path : std::as_const(m_prefetchPaths)) {
+        if (!wanted.contains(path)) ImageCache::instance()->cancelPrefetch(path);
+    }
+    QStringList previous = m_prefetchPaths;
+    m_prefetchPaths.clear();
+    for (const QString &path : std::as_const(wanted)) {
+        if (VectorRenderer::isVectorFile(path)) continue;
+        if (!previous.contains(path)) {
+            ImageCache::instance()->prefetch(path, currentPriority(TaskScheduler::Prefetch));
+        }
+        m_prefetchPaths << path;
+    }
+}
+
+void ImageTab::updateDecodePriorities()
+{
+    ImageCache *cache = ImageCache::instance();
+    if (!m_pendingDecodePath.isEmpty()) {
+        cache->setPriority(m_pendingDecodePath, currentPriority(TaskScheduler::Visible));
+    }
+    for (const QString &path : std::as_const(m_prefetchPaths)) {
+        cache->setPriority(path, currentPriority(TaskScheduler::Prefetch));
+    }
+    m_histogram->setPriority(currentPriority(TaskScheduler::Visible));
+}
+
+void ImageTab::setHistogramVisible(bool visible)
+{
+    if (visible) updateHudPosition();
+    m_overlay->setItemVisible(m_histogramOverlay, visible);
+    refreshHistogram();
+}
+
+void ImageTab::setLoupeEnabled(bool enabled)
+{
+    m_loupeEnabled = enabled;
+    // Move events without a button held only arrive with tracking on
+    m_canvas->setMouseTracking(enabled);
+    if (enabled) {
+        QPoint canvasPos = m_canvas->mapFromGlobal(QCursor::pos());
+        if (m_canvas->rect().contains(canvasPos)) updateLoupe(canvasPos);
+    } else {
+        m_overlay->setItemVisible(m_loupe, false);
+    }
+}
+
+void ImageTab::updateLoupe(const QPoint &canvasPos)
+{
+    if (!m_loadSuccess || m_canvas->width() <= 0 || m_canvas->height() <= 0
+        || !m_canvas->rect().contains(canvasPos)) {
+        m_overlay->setItemVisible(m_loupe, false);
+        return;
+    }
+
+    // Canvas to source pixel, straight from the zoom ratio, nothing is rescaled
+    const QSize source = m_pyramid.size();
+    QPoint pixel(int(double(canvasPos.x()) * source.width() / m_canvas->width()),
+                 int(double(canvasPos.y()) * source.height() / m_canvas->height()));
+    pixel.setX(qBound(0, pixel.x(), source.width() - 1));
+    pixel.setY(qBound(0, pixel.y(), source.height() - 1));
+    m_loupe->setPixel(pixel);
+
+    // Down and right of the cursor, flipped when it would leave the tab
+    const QPoint cursor = m_canvas->mapTo(this, canvasPos);
+    const QSize size = m_overlay->itemGeometry(m_loupe).size();
+    const int offset = 24;
+    int x = cursor.x() + offset;
+    int y = cursor.y() + offset;
+    if (x + size.width() > width()) x = cursor.x() - offset - size.width();
+    if (y + size.height() > height()) y = cursor.y() - offset - size.height();
+    m_overlay->moveItem(m_loupe, QPoint(x, y));
+    m_overlay->setItemVisible(m_loupe, true);
+}
+
+void ImageTab::refreshHistogram()
+{
+    // Counting is cheap for the preview but not free for 60 MP, skip it while nobody looks
+    if (m_histogramOverlay && m_overlay->isItemVisible(m_histogramOverlay) && m_loadSuccess) {
+        m_histogram->setImage(m_pyramid, currentPriority(TaskScheduler::Visible));
+    } else {
+        m_histogram->clear();
+    }
 }
 
 void ImageTab::updateImageDisplay()
 {
-    if (m_originalPixmap.isNull()) {
+    if (m_pyramid.isNull()) {
         return;
     }
     
     QSize viewportSize = m_scrollArea->viewport()->size();
     if (viewportSize.isEmpty()) return;
 
-    QSize baseSize = m_originalPixmap.size();
+    QSize baseSize = m_pyramid.size();
     baseSize.scale(viewportSize, Qt::KeepAspectRatio);
 
-    QSize targetSize = baseSize * m_zoomFactor;
-    m_imageLabel->resize(targetSize);
-    m_imageLabel->setPixmap(m_originalPixmap.scaled(targetSize, Qt::KeepAspectRatio, Qt::SmoothTransformation));
-    // Center widget in scroll area
-    m_imageLabel->setGeometry(
-        (viewportSize.width() - targetSize.width()) / 2,
-        (viewportSize.height() - targetSize.height()) / 2,
-        targetSize.width(),
-        targetSize.height()
-    );
+    // The scroll area keeps the canvas centered while it is smaller than the viewport.
+    // Vectors pull sharp rasters for the visible area at this size while painting.
+    // Scaled from the source rather than the rounded Fit size, so 1:1 is exact on both axes.
+    double scale = m_zoomFactor * baseSize.width() / m_pyramid.size().width();
+    QSize targetSize = m_pyramid.size() * scale;
+    m_canvas->resize(targetSize);
+    m_canvas->update();
+    m_displayedViewport = viewportSize;
+    m_displayedZoom = m_zoomFactor;
 
     // Update cursor based on zoom
     if (m_zoomFactor > 1.0) {
-        m_imageLabel->setCursor(Qt::OpenHandCursor);
+        m_canvas->setCursor(Qt::OpenHandCursor);
     } else {
-        m_imageLabel->setCursor(Qt::ArrowCursor);
+        m_canvas->setCursor(Qt::ArrowCursor);
     }
     
-    // Report Status
-    int currentIndex = m_images.indexOf(m_currentFilePath) + 1;
+    reportStatus();
+}
+
+void ImageTab::reportStatus()
+{
+    // A deleted image has no position any more
+    QString currentIndex = m_currentRemoved ? QString("-") : QString::number(m_currentIndex + 1);
     int total = m_images.count();
-    QString res = QString("%1 x %2").arg(m_originalPixmap.width()).arg(m_originalPixmap.height());
+
+    // Header index knows the resolution before the pixels are decoded
+    ImageMetadata meta = m_metadataIndex->metadata(QFileInfo(m_currentFilePath).absoluteFilePath());
+    QSize size = m_pyramid.isNull() ? meta.size : m_pyramid.size();
+    QString res = QString("%1 x %2").arg(size.width()).arg(size.height());
     int zoomPct = qRound(m_zoomFactor * 100);
     
     QString status = QString("Index: %1 / %2  |  Resolution: %3  |  Zoom: %4%")
         .arg(currentIndex).arg(total).arg(res).arg(zoomPct);
+    if (meta.isValid()) {
+        status += QString("  |  %1  |  %2")
+            .arg(QString::fromLatin1(meta.format).toUpper())
+            .arg(meta.captureTime.toString("yyyy-MM-dd HH:mm"));
+    }
+    if (m_sortMode != SortByName) {
+        status += QString("  |  Sort: %1").arg(sortModeName(m_sortMode));
+    }
+    if (m_folderWatcher) {
+        status += m_autoAdvance ? "  |  Live (auto-advance)" : "  |  Live";
+    }
+    if (m_currentRemoved) {
+        status += "  |  Deleted";
+    }
+    if (!m_similarityIndex->isReady()) {
+        if (m_similarityIndex->fileCount() > 0) {
+            status += QString("  |  Finding bursts: %1 / %2")
+                .arg(m_similarityIndex->hashedCount()).arg(m_similarityIndex->fileCount());
+        }
+    } else if (!m_currentRemoved && m_currentIndex >= 0 && m_currentIndex < m_images.size()) {
+        ensureBursts();
+        int first = burstStart(m_currentIndex);
+        int last = m_currentIndex;
+        while (last + 1 < m_bursts.size() && m_bursts.at(last + 1) == m_bursts.at(first)) last++;
+        status += QString("  |  Burst %1 / %2").arg(m_bursts.at(first) + 1).arg(m_bursts.last() + 1);
+        if (last > first) status += QString(" (%1 of %2)").arg(m_currentIndex - first + 1).arg(last - first + 1);
+    }
+    if (m_bestOfBurstOnly) {
+        status += "  |  Best of bursts";
+    }
         
     emit statusChanged(status);
 }
 
+double ImageTab::actualSizeFactor() const
+{
+    QSize viewportSize = m_scrollArea->viewport()->size();
+    if (m_pyramid.isNull() || viewportSize.isEmpty()) return 1.0;
+
+    QSize fitSize = m_pyramid.size().scaled(viewportSize, Qt::KeepAspectRatio);
+    if (fitSize.width() <= 0) return 1.0;
+    return double(m_pyramid.size().width()) / fitSize.width();
+}
+
+double ImageTab::maxZoom() const
+{
+    return ZoomMath::maxZoom(actualSizeFactor());
+}
+
+void ImageTab::applyZoom(double factor, const QPoint &anchor)
+{
+    if (!m_loadSuccess) return;
+
+    // Remember which image point sits under the anchor (viewport coordinates)
+    QPointF canvasPos = QPointF(anchor - m_canvas->pos());
+    QSizeF oldSize = m_canvas->size();
+    double rx = oldSize.width() > 0 ? canvasPos.x() / oldSize.width() : 0.5;
+    double ry = oldSize.height() > 0 ? canvasPos.y() / oldSize.height() : 0.5;
+
+    m_zoomFactor = qBound(ZoomMath::MIN_ZOOM, factor, maxZoom());
+    updateImageDisplay();
+
+    // And put it back under the anchor. Axes where the canvas fits stay centered.
+    QSize newSize = m_canvas->size();
+    m_scrollArea->horizontalScrollBar()->setValue(qRound(rx * newSize.width() - anchor.x()));
+    m_scrollArea->verticalScrollBar()->setValue(qRound(ry * newSize.height() - anchor.y()));
+    if (m_loupeEnabled) {
+        updateLoupe(m_canvas->mapFromGlobal(QCursor::pos()));
+    }
+}
+
+void ImageTab::animateZoomTo(double factor, const QPoint &anchor)
+{
+    if (!m_loadSuccess) return;
+
+    m_zoomFrom = m_zoomFactor;
+    m_zoomTo = qBound(ZoomMath::MIN_ZOOM, factor, maxZoom());
+    m_zoomAnchor = anchor;
+    m_zoomClock.restart();
+
+    // Tick at the refresh rate of the screen we are on
+    double refreshRate = screen() ? screen()->refreshRate() : 60.0;
+    if (refreshRate < 1.0) refreshRate = 60.0;
+    double frameMs = 1000.0 / refreshRate;
+    m_zoomTimer->setInterval(qMax(1, int(frameMs)));
+    m_canvas->setAnimating(true, frameMs * 0.5); // Leave the other half for layout and compositing
+
+    if (!m_zoomTimer->isActive()) {
+        m_zoomTimer->start();
+    }
+}
+
+void ImageTab::stopZoomAnimation()
+{
+    if (m_zoomTimer->isActive()) {
+        m_zoomTimer->stop();
+        m_canvas->setAnimating(false);
+    }
+}
+
+void ImageTab::onZoomFrame()
+{
+    double t = double(m_zoomClock.elapsed()) / ZOOM_ANIMATION_MS;
+    if (t >= 1.0) {
+        stopZoomAnimation();
+        applyZoom(m_zoomTo, m_zoomAnchor);
+        return;
+    }
+
+    // Ease out, interpolated geometrically so zooming in and out feel the same
+    double eased = 1.0 - std::pow(1.0 - t, 3.0);
+    applyZoom(m_zoomFrom * std::pow(m_zoomTo / m_zoomFrom, eased), m_zoomAnchor);
+}
+
+QPoint ImageTab::zoomAnchor() const
+{
+    // Cursor if it is over the image area, otherwise the viewport center
+    QWidget *viewport = m_scrollArea->viewport();
+    QPoint cursorPos = viewport->mapFromGlobal(QCursor::pos());
+    if (viewport->rect().contains(cursorPos)) return cursorPos;
+    return viewport->rect().center();
+}
+
 void ImageTab::updateCursor()
 {
     if (!m_loadSuccess) {
@@ -372,54 +1106,109 @@ void ImageTab::updateCursor()
 
 // Helper slots wrapping internal logic
 void ImageTab::zoomIn() {
-    m_zoomFactor *= 1.25;
-    updateImageDisplay();
+    double base = m_zoomTimer->isActive() ? m_zoomTo : m_zoomFactor;
+    animateZoomTo(base * 1.25, zoomAnchor());
 }
 
 void ImageTab::zoomOut() {
-    m_zoomFactor *= 0.8;
-    updateImageDisplay();
+    double base = m_zoomTimer->isActive() ? m_zoomTo : m_zoomFactor;
+    animateZoomTo(base * 0.8, zoomAnchor());
 }
 
 void ImageTab::zoomActualSize() {
-    // Calculate factor to show 1:1
-    // m_zoomFactor = 1.0 means "Fit to Screen" in logical terms for updateImageDisplay?
-    // Wait, updateImageDisplay uses logic: 
-    // QSize baseSize = (m_zoomFactor == 1.0) ? viewportSize : m_originalPixmap.size();
-    // So to get Actual Size (1:1), we want baseSize to be originalSize, but zoomFactor to be 1.0 if we defined it that way?
-    // Let's adjust logic.
-    // If m_zoomFactor == 1.0 -> Fit.
-    // If m_zoomFactor != 1.0 -> Multiplier of ORIGINAL size?
-    // Looking at updateImageDisplay line 214:
-    // QSize baseSize = (m_zoomFactor == 1.0) ? viewportSize : m_originalPixmap.size();
-    // QSize targetSize = baseSize * m_zoomFactor;
-    
-    // This logic is tricky. 
-    // If zoomFactor = 1.0, base is viewport. target is viewport. (FIT)
-    // If we want actual size: target must be original.
-    // So baseSize should be original. 
-    // We need a way to distinguish 'Fit' from 'Custom Zoom'.
-    // Let's use a small epsilon or a flag?
-    // OR: Change usage. 
-    // Let's say: m_zoomFactor represents scale relative to ORIGINAL.
-    // AND we have a separate boolean "m_fitToWindow".
-    // BUT avoiding architectural changes.
-    // HACK: Use 1.00001 for "Actual Size" vs 1.0 for "Fit"?
-    // OR: Just set m_zoomFactor to e.g. 1.01 (Actual) and modify updateImageDisplay to check EXACTLY 1.0.
-    
-    m_zoomFactor = 1.0001; // Treat as not-fit
-    updateImageDisplay();
+    // m_zoomFactor is relative to Fit (1.0), so 1:1 depends on the viewport size
+    animateZoomTo(actualSizeFactor(), zoomAnchor());
 }
 
 void ImageTab::resetZoom() {
-    m_zoomFactor = 1.0; // Fit
-    updateImageDisplay();
+    animateZoomTo(1.0, zoomAnchor()); // Fit
+}
+
+void ImageTab::ensureBursts()
+{
+    // While hashing is still running, whatever is known so far; recomputed on every use
+    if (m_bursts.size() != m_images.size() || !m_similarityIndex->isReady()) {
+        m_bursts = m_similarityIndex->groups(m_images);
+    }
+}
+
+int ImageTab::burstStart(int index) const
+{
+    // Bursts are runs of consecutive positions
+    while (index > 0 && m_bursts.at(index - 1) == m_bursts.at(index)) index--;
+    return index;
+}
+
+int ImageTab::bestOfBurst(int first) const
+{
+    int best = first;
+    float bestSharpness = -1.0f;
+    for (int i = first; i < m_bursts.size() && m_bursts.at(i) == m_bursts.at(first); ++i) {
+        ImageHash hash = m_similarityIndex->hash(m_images.at(i));
+        if (hash.isValid() && hash.sharpness > bestSharpness) {
+            bestSharpness = hash.sharpness;
+            best = i;
+        }
+    }
+    return best;
+}
+
+void ImageTab::showBurst(int delta)
+{
+    if (m_currentRemoved) {
+        // Nothing on screen to step from: the burst next to the gap on that side
+        const int neighbour = delta > 0 ? m_currentIndex : m_currentIndex - 1;
+        if (neighbour < 0 || neighbour >= m_images.size()) return;
+        ensureBursts();
+        const int target = burstStart(neighbour);
+        m_currentIndex = m_bestOfBurstOnly ? bestOfBurst(target) : target;
+        loadImage(m_images.at(m_currentIndex));
+        return;
+    }
+    if (m_currentIndex < 0 || m_currentIndex >= m_images.size()) return;
+    ensureBursts();
+
+    int target = m_currentIndex;
+    if (delta > 0) {
+        const int burst = m_bursts.at(m_currentIndex);
+        while (target < m_bursts.size() && m_bursts.at(target) == burst) target++;
+        if (target >= m_bursts.size()) return;
+    } else {
+        target = burstStart(m_currentIndex) - 1;
+        if (target < 0) return;
+        target = burstStart(target);
+    }
+
+    m_currentIndex = m_bestOfBurstOnly ? bestOfBurst(target) : target;
+    loadImage(m_images.at(m_currentIndex));
+}
+
+void ImageTab::setBestOfBurstOnly(bool enabled)
+{
+    m_bestOfBurstOnly = enabled;
+    if (enabled && m_currentIndex >= 0 && m_currentIndex < m_images.size()) {
+        // Settle on the pick of the burst we are in
+        ensureBursts();
+        int best = bestOfBurst(burstStart(m_currentIndex));
+        if (best != m_currentIndex) {
+            m_currentIndex = best;
+            loadImage(m_images.at(m_currentIndex));
+            return;
+        }
+    }
+    reportStatus();
 }
 
 void ImageTab::showNextImage()
 {
-    if (m_currentIndex < m_images.size() - 1) {
-        m_currentIndex++;
+    if (m_bestOfBurstOnly) {
+        showBurst(1);
+        return;
+    }
+    // After a deletion the successor already sits at m_currentIndex
+    const int next = m_currentRemoved ? m_currentIndex : m_currentIndex + 1;
+    if (next < m_images.size()) {
+        m_currentIndex = next;
         // Reset zoom on navigation
         m_zoomFactor = 1.0;
         loadImage(m_images.at(m_currentIndex));
@@ -428,6 +1217,10 @@ void ImageTab::showNextImage()
 
 void ImageTab::showPreviousImage()
 {
+    if (m_bestOfBurstOnly) {
+        showBurst(-1);
+        return;
+    }
     if (m_currentIndex > 0) {
         m_currentIndex--;
         loadImage(m_images.at(m_currentIndex));
@@ -2,23 +2,60 @@
 #define IMAGETAB_H
 
 #include <QWidget>
-#include <QPixmap>
+#include <QElapsedTimer>
+#include "imagepyramid.h"
+#include "session.h"
+#include "taskscheduler.h"
 
 class QPushButton;
-class QLabel;
 class QScrollArea;
+class QTimer;
+class FolderWatcher;
+class Histogram;
+class HistogramOverlay;
+class ImageCanvas;
+class OverlayLayer;
+class OverlayPanel;
+class PixelLoupe;
+struct DecodedImage;
+class MetadataIndex;
+class SimilarityIndex;
+class VectorRenderer;
 
 class ImageTab : public QWidget
 {
     Q_OBJECT
 public:
-    explicit ImageTab(const QString &filePath, QWidget *parent = nullptr);
+    enum SortMode {
+        SortByName,
+        SortByDate,
+        SortBySize,
+        SortByDimensions,
+        SortModeCount
+    };
+
+    enum LoadMode {
+        LoadNow,
+        LoadWhenShown // Restored tabs: no folder scan or decode until first shown
+    };
+
+    explicit ImageTab(const QString &filePath, QWidget *parent = nullptr, LoadMode mode = LoadNow);
+    ~ImageTab();
     
+    // Zoom and scroll position, for saving the session and restoring it later
+    Session::Tab viewState() const;
+    void restoreViewState(const Session::Tab &state);
+
     QString currentFilePath() const;
+    QStringList imageList() const;
+    int currentIndex() const;
+    double zoomFactor() const; // 1.0 = Fit
+    bool isImageLoaded() const;
 
 protected:
     void resizeEvent(QResizeEvent *event) override;
     void showEvent(QShowEvent *event) override;
+    void hideEvent(QHideEvent *event) override;
     void wheelEvent(QWheelEvent *event) override;
     void keyPressEvent(QKeyEvent *event) override;
     void mouseDoubleClickEvent(QMouseEvent *event) override;
@@ -28,6 +65,9 @@ protected:
 
 signals:
     void statusChanged(const QString &message);
+    void imageLoaded(const QString &path); // Pixels are on the canvas (or failed, see isImageLoaded)
+    // Keys 2-4: compare this image and the ones after it side by side
+    void compareRequested(const QStringList &images, const QList<int> &shown);
 
 private slots:
     void showNextImage();
@@ -36,6 +76,9 @@ private slots:
     void zoomOut();
     void resetZoom(); // Fit to screen
     void zoomActualSize(); // 100%
+    void onZoomFrame();
+    void onFilesReady(const QStringList &paths);
+    void onFilesRemoved(const QStringList &paths);
 
 private:
     void updateHudPosition();
@@ -45,21 +88,95 @@ private:
     // ... existing private members ...
 
 private:
+    void materialize();
+    void applyPendingView();
     void updateImageDisplay();
+    void reportStatus();
+    static bool isSupportedFile(const QString &path);
     void scanFolder();
+    // Live mode: follow files being added to / removed from the folder
+    void setLiveMode(bool enabled);
+    int nameOrderPosition(const QString &path) const;
+    void applySortMode();
+    void cycleSortMode();
+    // Bursts of similar shots: PageUp/PageDown jump between them, B shows only the best of each
+    void ensureBursts();
+    int burstStart(int index) const;
+    int bestOfBurst(int first) const;
+    void showBurst(int delta);
+    void setBestOfBurstOnly(bool enabled);
     void loadImage(const QString &path);
+    void showDecodedImage(const DecodedImage &image);
+
+    // Background decoding
+    TaskScheduler::Priority currentPriority(TaskScheduler::Priority whenVisible) const;
+    void releasePendingDecode();
+    void prefetchNeighbors();
+    void updateDecodePriorities();
     void updateCursor();
 
+    // Histogram overlay (H), only computed while shown
+    void setHistogramVisible(bool visible);
+    void refreshHistogram();
+
+    // Pixel loupe (M), follows the cursor over the canvas
+    void setLoupeEnabled(bool enabled);
+    void updateLoupe(const QPoint &canvasPos);
+
+    // Zoom: factor is relative to Fit (1.0), anchor is in viewport coordinates
+    double actualSizeFactor() const;
+    double maxZoom() const;
+    void applyZoom(double factor, const QPoint &anchor);
+    void zoomByWheel(const QWheelEvent *event, const QPoint &anchor);
+    void animateZoomTo(double factor, const QPoint &anchor);
+    void stopZoomAnimation();
+    QPoint zoomAnchor() const;
+
     QString m_currentFilePath;
-    QPixmap m_originalPixmap;
-    QLabel *m_imageLabel;
+    bool m_materialized;
+    bool m_hasPendingView;
+    Session::Tab m_pendingView;
+    ImagePyramid m_pyramid;
+    ImageCanvas *m_canvas;
     QScrollArea *m_scrollArea;
+    VectorRenderer *m_vectorRenderer;
+    bool m_isVector;
+    int m_loadGeneration;
+    QString m_pendingDecodePath;
+    QStringList m_prefetchPaths;
+    Histogram *m_histogram;
+    OverlayLayer *m_overlay; // HUD backdrop, histogram and loupe
+    OverlayPanel *m_hudPanel;
+    HistogramOverlay *m_histogramOverlay;
+    PixelLoupe *m_loupe;
+    bool m_loupeEnabled;
     
     QStringList m_images;
+    QStringList m_nameOrder;
+    MetadataIndex *m_metadataIndex;
+    SortMode m_sortMode;
+    SimilarityIndex *m_similarityIndex;
+    QString m_hashFolder; // Hashed once its header pass is done, empty when started
+    QVector<int> m_bursts; // Burst number per position of m_images, empty when stale
+    bool m_bestOfBurstOnly;
+    FolderWatcher *m_folderWatcher;
+    bool m_autoAdvance;
     int m_currentIndex;
+    // The one on screen was deleted; m_currentIndex is then the slot its successor took
+    bool m_currentRemoved;
     bool m_loadSuccess;
     
     double m_zoomFactor;
+    // What the canvas was last laid out for, re-show skips relayout when unchanged
+    QSize m_displayedViewport;
+    double m_displayedZoom;
+
+    // Zoom animation state
+    QTimer *m_zoomTimer;
+    QElapsedTimer m_zoomClock;
+    double m_zoomFrom;
+    double m_zoomTo;
+    QPoint m_zoomAnchor;
     
     // Dragging state
     bool m_isDragging;
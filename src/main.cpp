@@ -3,10 +3,16 @@
 #include <QDataStream>
 #include <QFile>
 #include <QIcon>
+#include "batchprocessor.h"
 #include "mainwindow.h"
 
 int main(int argc, char *argv[])
 {
+    // Headless batch jobs (--batch-thumbnail / --convert) never create a window
+    if (BatchProcessor::isBatchInvocation(argc, argv)) {
+        return BatchProcessor::run(argc, argv);
+    }
+
     QApplication a(argc, argv);
     
     // Global Window Icon
@@ -42,7 +48,7 @@ int main(int argc, char *argv[])
         for (const QString &arg : args) {
             w.openImageInNewTab(arg);
         }
-    } else {
+    } else if (!w.restoreSession()) {
         w.showWelcomeTab();
     }
     
@@ -1,5 +1,10 @@
 #include "mainwindow.h"
+#include "compareview.h"
 #include "imagetab.h"
+#include "painttrace.h"
+#include "session.h"
+#include "ziparchive.h"
+#include "taskscheduler.h"
 #include <QTabWidget>
 #include <QLabel>
 #include <QVBoxLayout>
@@ -8,6 +13,7 @@
 #include <QLocalSocket>
 #include <QDataStream>
 #include <QApplication>
+#include <QCloseEvent>
 #include <QPushButton>
 #include <QFileDialog>
 #include <QIcon>
@@ -80,6 +86,13 @@ MainWindow::MainWindow(QWidget *parent)
     new QShortcut(QKeySequence::New, this, SLOT(showWelcomeTab())); // Ctrl+N
     // Note: Ctrl+Tab might be consumed by QTabWidget by default, but explicit shortcut ensures it.
     
+    // F12: Background work counters (decode, prefetch, indexing) and repaint cost in the status bar
+    QShortcut *statsShortcut = new QShortcut(QKeySequence(Qt::Key_F12), this);
+    connect(statsShortcut, &QShortcut::activated, this, [this]() {
+        statusBar()->showMessage(TaskScheduler::instance()->summary() + "  |  "
+                                 + PaintTrace::instance()->summary(), 10000);
+    });
+    
     // Corner Widget for "New Tab" button
     QToolButton *newTabBtn = new QToolButton(this);
     newTabBtn->setText("+");
@@ -106,6 +119,60 @@ MainWindow::~MainWindow()
 {
 }
 
+bool MainWindow::restoreSession()
+{
+    Session session = Session::load();
+    if (!session.windowGeometry.isEmpty()) restoreGeometry(session.windowGeometry);
+
+    // Titles come back right away; each tab scans and decodes the first time it is shown
+    ImageTab *current = nullptr;
+    ImageTab *first = nullptr;
+    for (int i = 0; i < session.tabs.size(); ++i) {
+        const Session::Tab &state = session.tabs.at(i);
+        // Files deleted or unmounted since are dropped silently
+        if (!QFileInfo::exists(ZipArchive::physicalPath(state.filePath))) continue;
+
+        ImageTab *tab = new ImageTab(state.filePath, this, ImageTab::LoadWhenShown);
+        tab->restoreViewState(state);
+        connect(tab, &ImageTab::statusChanged, this, &MainWindow::updateStatusBar);
+        connect(tab, &ImageTab::compareRequested, this, &MainWindow::openCompareTab);
+        m_tabWidget->addTab(tab, QFileInfo(state.filePath).fileName());
+        if (!first) first = tab;
+        if (i == session.currentTab) current = tab;
+    }
+    if (!first) return false;
+
+    // Switch first, so removing the welcome tab doesn't show (and load) some other tab
+    m_tabWidget->setCurrentWidget(current ? current : first);
+    for (int i = m_tabWidget->count() - 1; i >= 0; --i) {
+        QWidget *widget = m_tabWidget->widget(i);
+        if (!qobject_cast<ImageTab*>(widget) && m_tabWidget->tabText(i) == "Welcome") {
+            m_tabWidget->removeTab(i);
+            widget->deleteLater();
+        }
+    }
+    return true;
+}
+
+void MainWindow::saveSession() const
+{
+    Session session;
+    session.windowGeometry = saveGeometry();
+    for (int i = 0; i < m_tabWidget->count(); ++i) {
+        ImageTab *tab = qobject_cast<ImageTab*>(m_tabWidget->widget(i));
+        if (!tab) continue; // Welcome and info tabs are not worth restoring
+        if (i == m_tabWidget->currentIndex()) session.currentTab = int(session.tabs.size());
+        session.tabs.append(tab->viewState());
+    }
+    session.save();
+}
+
+void MainWindow::closeEvent(QCloseEvent *event)
+{
+    saveSession();
+    QMainWindow::closeEvent(event);
+}
+
 void MainWindow::closeTab(int index)
 {
     QWidget *widget = m_tabWidget->widget(index);
@@ -122,7 +189,7 @@ void MainWindow::closeTab(int index)
 
 void MainWindow::openFileDialog()
 {
-    QString fileName = QFileDialog::getOpenFileName(this, "Open Image", m_lastOpenPath, "Images (*.png *.jpg *.jpeg *.bmp *.webp)");
+    QString fileName = QFileDialog::getOpenFileName(this, "Open Image", m_lastOpenPath, "Images (*.png *.jpg *.jpeg *.bmp *.webp *.svg *.svgz);;Archives (*.zip *.cbz)");
     if (!fileName.isEmpty()) {
         openImageInNewTab(fileName);
     }
@@ -193,11 +260,22 @@ void MainWindow::addImageTab(const QString &filePath)
     // Create new.
     ImageTab *tab = new ImageTab(absolutePath, this);
     connect(tab, &ImageTab::statusChanged, this, &MainWindow::updateStatusBar);
+    connect(tab, &ImageTab::compareRequested, this, &MainWindow::openCompareTab);
     
     m_tabWidget->addTab(tab, fileInfo.fileName());
     m_tabWidget->setCurrentWidget(tab);
 }
 
+void MainWindow::openCompareTab(const QStringList &images, const QList<int> &shown)
+{
+    CompareView *view = new CompareView(images, shown, this);
+    connect(view, &CompareView::statusChanged, this, &MainWindow::updateStatusBar);
+
+    m_tabWidget->addTab(view, QString("Compare (%1)").arg(qBound(CompareView::MIN_PANES, int(shown.size()), CompareView::MAX_PANES)));
+    m_tabWidget->setCurrentWidget(view);
+    view->setFocus();
+}
+
 void MainWindow::handleNewConnection()
 {
     QLocalSocket *socket = m_localServer->nextPendingConnection();
@@ -2,6 +2,7 @@
 #define MAINWINDOW_H
 
 #include <QMainWindow>
+#include <QStringList>
 
 class QTabWidget;
 
@@ -15,13 +16,19 @@ public:
     explicit MainWindow(QWidget *parent = nullptr);
     ~MainWindow();
 
+    // Reopens the tabs of the last session; false if there was nothing to restore
+    bool restoreSession();
+    void saveSession() const;
+
 protected:
+    void closeEvent(QCloseEvent *event) override;
     void dragEnterEvent(QDragEnterEvent *event) override;
     void dropEvent(QDropEvent *event) override;
 
 public:
     void addImageTab(const QString &filePath);
     void openImageInNewTab(const QString &filePath); // Alias/Wrapper
+    void openCompareTab(const QStringList &images, const QList<int> &shown);
     
     // Info Tabs
     void openInfoTab(const QString &title, const QString &content);
@@ -0,0 +1,89 @@
+#include "memorybudget.h"
+#include <QtGlobal>
+#ifdef Q_OS_UNIX
+#include <unistd.h>
+#endif
+
+namespace {
+    constexpr qint64 MB = 1024 * 1024;
+    constexpr qint64 DEFAULT_LIMIT = 1024 * MB;
+
+    qint64 defaultLimit()
+    {
+        // MYVIEW_MEMORY_MB overrides, otherwise a quarter of physical memory
+        bool ok = false;
+        qint64 overrideMb = qEnvironmentVariableIntValue("MYVIEW_MEMORY_MB", &ok);
+        if (ok && overrideMb > 0) return overrideMb * MB;
+
+#ifdef Q_OS_UNIX
+        long pages = sysconf(_SC_PHYS_PAGES);
+        long pageSize = sysconf(_SC_PAGESIZE);
+        if (pages > 0 && pageSize > 0) {
+            return qMax(256 * MB, qint64(pages) * pageSize / 4);
+        }
+#endif
+        return DEFAULT_LIMIT;
+    }
+}
+
+MemoryBudget::MemoryBudget(QObject *parent)
+    : QObject(parent)
+    , m_used(0)
+    , m_limit(defaultLimit())
+{
+}
+
+MemoryBudget *MemoryBudget::instance()
+{
+    // Outlives every tab and cache, they release into it on destruction
+    static MemoryBudget budget;
+    return &budget;
+}
+
+qint64 MemoryBudget::limit() const
+{
+    return m_limit.loadRelaxed();
+}
+
+void MemoryBudget::setLimit(qint64 bytes)
+{
+    m_limit.storeRelaxed(bytes);
+    if (isOverBudget()) emit pressure();
+}
+
+qint64 MemoryBudget::used() const
+{
+    return m_used.loadRelaxed();
+}
+
+bool MemoryBudget::isOverBudget() const
+{
+    return used() > limit();
+}
+
+void MemoryBudget::charge(qint64 bytes)
+{
+    if (bytes <= 0) return;
+    qint64 before = m_used.fetchAndAddRelaxed(bytes);
+    // Only signal on crossing, trimming caches release again and we would loop otherwise
+    if (before <= limit() && before + bytes > limit()) {
+        emit pressure();
+    }
+}
+
+void MemoryBudget::release(qint64 bytes)
+{
+    if (bytes <= 0) return;
+    m_used.fetchAndSubRelaxed(bytes);
+}
+
+void MemoryCharge::set(qint64 bytes)
+{
+    if (bytes == m_bytes) return;
+    if (bytes > m_bytes) {
+        MemoryBudget::instance()->charge(bytes - m_bytes);
+    } else {
+        MemoryBudget::instance()->release(m_bytes - bytes);
+    }
+    m_bytes = bytes;
+}
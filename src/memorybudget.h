@@ -0,0 +1,51 @@
+#ifndef MEMORYBUDGET_H
+#define MEMORYBUDGET_H
+
+#include <QObject>
+#include <QAtomicInteger>
+
+// Process wide accounting for the big allocations we keep around on purpose
+// (decoded images, pyramids, render caches). Caches charge what they hold and
+// drop entries when pressure() is emitted. Safe to charge from any thread.
+class MemoryBudget : public QObject
+{
+    Q_OBJECT
+public:
+    static MemoryBudget *instance();
+
+    qint64 limit() const;
+    void setLimit(qint64 bytes);
+    qint64 used() const;
+    bool isOverBudget() const;
+
+    void charge(qint64 bytes);
+    void release(qint64 bytes);
+
+signals:
+    // Usage went over the limit, holders of optional memory should trim
+    void pressure();
+
+private:
+    explicit MemoryBudget(QObject *parent = nullptr);
+
+    QAtomicInteger<qint64> m_used;
+    QAtomicInteger<qint64> m_limit;
+};
+
+// Tracks one holder's share of the budget, released on destruction
+class MemoryCharge
+{
+public:
+    MemoryCharge() : m_bytes(0) {}
+    ~MemoryCharge() { set(0); }
+    MemoryCharge(const MemoryCharge &) = delete;
+    MemoryCharge &operator=(const MemoryCharge &) = delete;
+
+    void set(qint64 bytes);
+    qint64 bytes() const { return m_bytes; }
+
+private:
+    qint64 m_bytes;
+};
+
+#endif // MEMORYBUDGET_H
@@ -0,0 +1,378 @@
+#include "metadataindex.h"
+#include "ziparchive.h"
+#include <QBuffer>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QImageReader>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <cstring>
+
+namespace {
+    constexpr quint32 CACHE_MAGIC = 0x4d56494d; // "MVIM"
+    constexpr qint32 CACHE_VERSION = 1;
+    // Files per scheduler task. Tasks also yield between files when more urgent
+    // work is queued, so this only bounds scheduling overhead.
+    constexpr int CHUNK_SIZE = 128;
+    // EXIF lives in APP1, which is at most 64 KB and normally right after SOI
+    constexpr qint64 EXIF_SCAN_BYTES = 128 * 1024;
+
+    quint16 read16(const uchar *p, bool le)
+    {
+        return le ? quint16(p[0] | (p[1] << 8)) : quint16((p[0] << 8) | p[1]);
+    }
+
+    quint32 read32(const uchar *p, bool le)
+    {
+        return le ? quint32(p[0] | (p[1] << 8) | (p[2] << 16) | (quint32(p[3]) << 24))
+                  : quint32((quint32(p[0]) << 24) | (p[1] << 16) | (p[2] << 8) | p[3]);
+    }
+
+    // Minimal TIFF/EXIF walk: IFD0 orientation + DateTime, Exif IFD DateTimeOriginal
+    void parseTiff(const uchar *tiff, quint32 len, ImageMetadata *meta)
+    {
+        if (len < 8) return;
+        bool le = tiff[0] == 'I' && tiff[1] == 'I';
+        if (!le && !(tiff[0] == 'M' && tiff[1] == 'M')) return;
+        if (read16(tiff + 2, le) != 42) return;
+
+        auto readAscii = [&](const uchar *entry) -> QString {
+            quint32 count = read32(entry + 4, le);
+            if (count == 0) return QString();
+            const uchar *value = entry + 8;
+            if (count > 4) {
+                quint32 offset = read32(entry + 8, le);
+                if (offset >= len || count > len - offset) return QString();
+                value = tiff + offset;
+            }
+            return QString::fromLatin1(reinterpret_cast<const char *>(value), int(count) - 1);
+        };
+
+        QString dateTime;
+        QString dateTimeOriginal;
+        quint32 exifOffset = 0;
+
+        auto walkIfd = [&](quint32 offset, bool isIfd0) {
+            // Offsets come straight from the file: compare by subtracting, a sum can wrap
+            if (offset == 0 || offset >= len || len - offset < 2) return;
+            // Entries running past the end of the blob are dropped
+            const quint32 count = qMin<quint32>(read16(tiff + offset, le), (len - offset - 2) / 12);
+            for (quint32 i = 0; i < count; ++i) {
+                const uchar *entry = tiff + offset + 2 + i * 12;
+                quint16 tag = read16(entry, le);
+                if (isIfd0 && tag == 0x0112) {
+                    meta->orientation = read16(entry + 8, le);
+                } else if (isIfd0 && tag == 0x0132) {
+                    dateTime = readAscii(entry);
+                } else if (isIfd0 && tag == 0x8769) {
+                    exifOffset = read32(entry + 8, le);
+                } else if (!isIfd0 && tag == 0x9003) {
+                    dateTimeOriginal = readAscii(entry);
+                }
+            }
+        };
+
+        walkIfd(read32(tiff + 4, le), true);
+        walkIfd(exifOffset, false);
+
+        QString stamp = dateTimeOriginal.isEmpty() ? dateTime : dateTimeOriginal;
+        QDateTime parsed = QDateTime::fromString(stamp.trimmed(), "yyyy:MM:dd HH:mm:ss");
+        if (parsed.isValid()) meta->captureTime = parsed;
+        if (meta->orientation < 1 || meta->orientation > 8) meta->orientation = 1;
+    }
+
+    void readJpegExif(const QByteArray &head, ImageMetadata *meta)
+    {
+        const uchar *buf = reinterpret_cast<const uchar *>(head.constData());
+        const int len = head.size();
+        if (len < 4 || buf[0] != 0xFF || buf[1] != 0xD8) return;
+
+        int pos = 2;
+        while (pos + 4 <= len) {
+            if (buf[pos] != 0xFF) return;
+            uchar marker = buf[pos + 1];
+            if (marker == 0xFF) { pos++; continue; } // Fill byte
+            if (marker == 0xDA || marker == 0xD9) return; // Image data starts, no EXIF
+            int segmentLength = (buf[pos + 2] << 8) | buf[pos + 3];
+            if (marker == 0xE1 && segmentLength >= 8 && pos + 10 <= len
+                && std::memcmp(buf + pos + 4, "Exif\0\0", 6) == 0) {
+                int tiffStart = pos + 10;
+                int tiffLength = qMin(segmentLength - 8, len - tiffStart);
+                parseTiff(buf + tiffStart, quint32(tiffLength), meta);
+                return;
+            }
+            pos += 2 + segmentLength;
+        }
+    }
+
+    void readHeader(QIODevice &device, ImageMetadata *meta)
+    {
+        // Header only, QImageReader::size() does not decode pixels
+        QImageReader reader(&device);
+        meta->format = reader.format();
+        meta->size = reader.size();
+
+        if (meta->format == "jpeg" || meta->format == "jpg") {
+            device.seek(0);
+            readJpegExif(device.read(EXIF_SCAN_BYTES), meta);
+        }
+    }
+
+    QString cacheFilePath(const QString &folder)
+    {
+        QString dir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/metadata";
+        QByteArray hash = QCryptographicHash::hash(folder.toUtf8(), QCryptographicHash::Sha1).toHex();
+        return dir + "/" + QString::fromLatin1(hash) + ".idx";
+    }
+
+    QDataStream &operator<<(QDataStream &out, const ImageMetadata &meta)
+    {
+        return out << meta.path << meta.fileSize << meta.modified << meta.size
+                   << meta.format << meta.captureTime << qint32(meta.orientation);
+    }
+
+    QDataStream &operator>>(QDataStream &in, ImageMetadata &meta)
+    {
+        qint32 orientation = 1;
+        in >> meta.path >> meta.fileSize >> meta.modified >> meta.size
+           >> meta.format >> meta.captureTime >> orientation;
+        meta.orientation = orientation;
+        return in;
+    }
+
+    QHash<QString, ImageMetadata> loadCache(const QString &folder)
+    {
+        QHash<QString, ImageMetadata> entries;
+        QFile file(cacheFilePath(folder));
+        if (!file.open(QIODevice::ReadOnly)) return entries;
+
+        QDataStream in(&file);
+        quint32 magic = 0;
+        qint32 version = 0;
+        qint32 count = 0;
+        in >> magic >> version >> count;
+        if (magic != CACHE_MAGIC || version != CACHE_VERSION || count < 0) return entries;
+
+        entries.reserve(count);
+        for (qint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+            ImageMetadata meta;
+            in >> meta;
+            entries.insert(meta.path, meta);
+        }
+        if (in.status() != QDataStream::Ok) entries.clear(); // Truncated, start over
+        return entries;
+    }
+
+    void saveCache(const QString &folder, const QHash<QString, ImageMetadata> &entries)
+    {
+        QString path = cacheFilePath(folder);
+        QDir().mkpath(QFileInfo(path).absolutePath());
+
+        QSaveFile file(path);
+        if (!file.open(QIODevice::WriteOnly)) return;
+        QDataStream out(&file);
+        out << CACHE_MAGIC << CACHE_VERSION << qint32(entries.size());
+        for (const ImageMetadata &meta : entries) {
+            out << meta;
+        }
+        file.commit();
+    }
+
+    struct CacheLookup {
+        QList<ImageMetadata> current;
+        QFileInfoList stale;
+        int cachedCount = 0;
+    };
+
+    struct ChunkResult {
+        QList<ImageMetadata> read;
+        QFileInfoList rest; // Not read yet, the task yielded its worker
+    };
+
+    // Splits the listing into entries still valid in the disk cache and files to read
+    CacheLookup lookupCache(const QString &folder, const QFileInfoList &files)
+    {
+        QHash<QString, ImageMetadata> cached = loadCache(folder);
+        CacheLookup lookup;
+        lookup.cachedCount = cached.size();
+        lookup.current.reserve(files.size());
+
+        for (const QFileInfo &info : files) {
+            auto it = cached.constFind(info.absoluteFilePath());
+            qint64 size = 0;
+            qint64 modified = 0;
+            if (it != cached.constEnd()) MetadataIndex::fileStamp(info, &size, &modified);
+            if (it != cached.constEnd() && it->fileSize == size && it->modified == modified) {
+                lookup.current.append(it.value());
+            } else {
+                lookup.stale.append(info);
+            }
+        }
+        return lookup;
+    }
+}
+
+MetadataIndex::MetadataIndex(QObject *parent)
+    : QObject(parent)
+    , m_ready(false)
+    , m_remainingChunks(0)
+    , m_cacheDirty(false)
+{
+}
+
+MetadataIndex::~MetadataIndex()
+{
+    cancel();
+}
+
+void MetadataIndex::fileStamp(const QFileInfo &info, qint64 *size, qint64 *modified)
+{
+    // Archive members report their own, from the central directory
+    ZipArchive::Member member;
+    if (ZipArchive::memberInfo(info.absoluteFilePath(), &member)) {
+        *size = member.size;
+        *modified = member.modified.toMSecsSinceEpoch();
+    } else {
+        *size = info.size();
+        *modified = info.lastModified().toMSecsSinceEpoch();
+    }
+}
+
+ImageMetadata MetadataIndex::read(const QFileInfo &info)
+{
+    ImageMetadata meta;
+    meta.path = info.absoluteFilePath();
+    fileStamp(info, &meta.fileSize, &meta.modified);
+
+    if (ZipArchive::isVirtualPath(meta.path)) {
+        // Archive member: only the first bytes get inflated, enough for header and EXIF
+        QByteArray head = ZipArchive::readMember(meta.path, EXIF_SCAN_BYTES);
+        QBuffer buffer(&head);
+        if (buffer.open(QIODevice::ReadOnly)) readHeader(buffer, &meta);
+    } else {
+        QFile file(meta.path);
+        if (file.open(QIODevice::ReadOnly)) readHeader(file, &meta);
+    }
+
+    if (meta.orientation >= 5) meta.size.transpose(); // Rotated by 90 degrees on display
+    if (!meta.captureTime.isValid()) meta.captureTime = QDateTime::fromMSecsSinceEpoch(meta.modified);
+    return meta;
+}
+
+void MetadataIndex::cancel()
+{
+    for (TaskHandle &task : m_tasks) {
+        task.cancel();
+    }
+    m_tasks.clear();
+    m_remainingChunks = 0;
+}
+
+void MetadataIndex::index(const QString &folder, const QFileInfoList &files)
+{
+    cancel();
+    m_ready = false;
+    m_entries.clear();
+    m_folder = folder;
+    m_cacheDirty = false;
+
+    // Cache lookup first, then header reads in chunks, all at Background priority.
+    // The lookup counts as pending work until its chunks are queued.
+    m_remainingChunks = 1;
+    m_tasks << TaskScheduler::instance()->submit<CacheLookup>(TaskScheduler::Background, folder, this,
+        [folder, files](const TaskContext &) { return lookupCache(folder, files); },
+        [this](const CacheLookup &lookup) { onCacheLoaded(lookup.current, lookup.stale, lookup.cachedCount); });
+}
+
+void MetadataIndex::update(const QFileInfoList &added, const QStringList &removed)
+{
+    for (const QString &path : removed) {
+        m_cacheDirty |= m_entries.remove(path) > 0;
+    }
+    if (added.isEmpty()) {
+        // Nothing to read; finish() saves later if an index run is still going
+        if (m_remainingChunks == 0 && m_cacheDirty) finish();
+        return;
+    }
+    m_cacheDirty = true;
+    readInBackground(added);
+}
+
+void MetadataIndex::onCacheLoaded(const QList<ImageMetadata> &current, const QFileInfoList &stale, int cachedCount)
+{
+    m_entries.reserve(current.size() + stale.size());
+    for (const ImageMetadata &meta : current) {
+        // Files updated while the lookup ran are already fresher
+        if (!m_entries.contains(meta.path)) m_entries.insert(meta.path, meta);
+    }
+    // Rewrite the disk cache when something gets read or files disappeared
+    m_cacheDirty |= !stale.isEmpty() || current.size() != cachedCount;
+
+    readInBackground(stale);
+    if (--m_remainingChunks == 0) {
+        finish();
+    }
+}
+
+void MetadataIndex::readInBackground(const QFileInfoList &files)
+{
+    for (int start = 0; start < files.size(); start += CHUNK_SIZE) {
+        QFileInfoList chunk = files.mid(start, CHUNK_SIZE);
+        m_remainingChunks++;
+        m_tasks << TaskScheduler::instance()->submit<ChunkResult>(TaskScheduler::Background, m_folder, this,
+            [chunk](const TaskContext &ctx) {
+                ChunkResult result;
+                result.read.reserve(chunk.size());
+                for (int i = 0; i < chunk.size(); ++i) {
+                    // Visible work is waiting and every worker is busy: hand this one over
+                    if (i > 0 && ctx.shouldYield()) {
+                        result.rest = chunk.mid(i);
+                        break;
+                    }
+                    result.read.append(read(chunk.at(i)));
+                }
+                return result;
+            },
+            [this](const ChunkResult &result) { onChunkRead(result.read, result.rest); });
+    }
+}
+
+void MetadataIndex::onChunkRead(const QList<ImageMetadata> &chunk, const QFileInfoList &rest)
+{
+    for (const ImageMetadata &meta : chunk) {
+        m_entries.insert(meta.path, meta);
+    }
+    // Back to the end of the Background queue, behind whatever preempted it
+    readInBackground(rest);
+    if (--m_remainingChunks == 0) {
+        finish();
+    }
+}
+
+void MetadataIndex::finish()
+{
+    m_tasks.clear();
+    m_ready = true;
+
+    if (m_cacheDirty) {
+        QString folder = m_folder;
+        QHash<QString, ImageMetadata> entries = m_entries;
+        TaskScheduler::instance()->submit(TaskScheduler::Background, folder, [folder, entries](const TaskContext &) {
+            saveCache(folder, entries);
+        });
+        m_cacheDirty = false;
+    }
+    emit ready();
+}
+
+bool MetadataIndex::isReady() const
+{
+    return m_ready;
+}
+
+ImageMetadata MetadataIndex::metadata(const QString &path) const
+{
+    return m_entries.value(path);
+}
@@ -0,0 +1,63 @@
+#ifndef METADATAINDEX_H
+#define METADATAINDEX_H
+
+#include <QObject>
+#include <QDateTime>
+#include <QFileInfo>
+#include <QHash>
+#include <QSize>
+#include "taskscheduler.h"
+
+// What we can learn about an image without decoding its pixels
+struct ImageMetadata
+{
+    QString path;
+    qint64 fileSize = 0;
+    qint64 modified = 0;    // mtime, ms since epoch; with fileSize decides if a cache entry is stale
+    QSize size;             // Already swapped for EXIF orientations 5-8
+    QByteArray format;
+    QDateTime captureTime;  // EXIF DateTimeOriginal, falls back to mtime
+    int orientation = 1;    // EXIF orientation tag, 1 = upright
+
+    bool isValid() const { return !path.isEmpty(); }
+};
+
+// Background indexer for one folder. Reads headers and EXIF only, in chunks of
+// Background priority scheduler tasks, and keeps the results in an on-disk cache keyed by
+// path + mtime so reopening a folder only touches files that changed.
+class MetadataIndex : public QObject
+{
+    Q_OBJECT
+public:
+    explicit MetadataIndex(QObject *parent = nullptr);
+    ~MetadataIndex();
+
+    static ImageMetadata read(const QFileInfo &info);
+    // Size and mtime that decide whether a cache entry is stale
+    static void fileStamp(const QFileInfo &info, qint64 *size, qint64 *modified);
+
+    void index(const QString &folder, const QFileInfoList &files);
+    // Live folders: reads only the added (or rewritten) files, emits ready() again when done
+    void update(const QFileInfoList &added, const QStringList &removed);
+    bool isReady() const;
+    ImageMetadata metadata(const QString &path) const;
+
+signals:
+    void ready();
+
+private:
+    void cancel();
+    void onCacheLoaded(const QList<ImageMetadata> &current, const QFileInfoList &stale, int cachedCount);
+    void readInBackground(const QFileInfoList &files);
+    void onChunkRead(const QList<ImageMetadata> &chunk, const QFileInfoList &rest);
+    void finish();
+
+    QString m_folder;
+    QHash<QString, ImageMetadata> m_entries;
+    QList<TaskHandle> m_tasks;
+    bool m_ready;
+    int m_remainingChunks;
+    bool m_cacheDirty;
+};
+
+#endif // METADATAINDEX_H
@@ -0,0 +1,146 @@
+#include "overlaylayer.h"
+#include "painttrace.h"
+#include <QElapsedTimer>
+#include <QPainter>
+#include <QPaintEvent>
+
+OverlayItem::OverlayItem(QObject *parent)
+    : QObject(parent)
+{
+}
+
+OverlayPanel::OverlayPanel(const QColor &color, qreal radius, QObject *parent)
+    : OverlayItem(parent)
+    , m_color(color)
+    , m_radius(radius)
+{
+}
+
+QSize OverlayPanel::sizeHint() const
+{
+    return QSize(); // Sized by whoever places it
+}
+
+void OverlayPanel::paint(QPainter &painter, const QSize &size) const
+{
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setPen(Qt::NoPen);
+    painter.setBrush(m_color);
+    painter.drawRoundedRect(QRectF(QPointF(0, 0), QSizeF(size)), m_radius, m_radius);
+}
+
+OverlayLayer::OverlayLayer(QWidget *parent)
+    : QWidget(parent)
+{
+    // Buttons and the canvas underneath keep getting the mouse
+    setAttribute(Qt::WA_TransparentForMouseEvents);
+    setAttribute(Qt::WA_NoSystemBackground);
+}
+
+void OverlayLayer::addItem(OverlayItem *item)
+{
+    Entry entry;
+    entry.item = item;
+    entry.rect = QRect(QPoint(0, 0), item->sizeHint());
+    m_entries.append(entry);
+
+    connect(item, &OverlayItem::changed, this, [this, item]() {
+        Entry *entry = find(item);
+        if (!entry) return;
+        entry->cache = QPixmap();
+        if (entry->visible) update(entry->rect);
+    });
+    connect(item, &QObject::destroyed, this, [this, item]() {
+        for (int i = 0; i < m_entries.size(); ++i) {
+            if (m_entries.at(i).item == item) {
+                if (m_entries.at(i).visible) update(m_entries.at(i).rect);
+                m_entries.removeAt(i);
+                return;
+            }
+        }
+    });
+}
+
+void OverlayLayer::setItemVisible(OverlayItem *item, bool visible)
+{
+    Entry *entry = find(item);
+    if (!entry || entry->visible == visible) return;
+    entry->visible = visible;
+    update(entry->rect);
+}
+
+bool OverlayLayer::isItemVisible(OverlayItem *item) const
+{
+    const Entry *entry = find(item);
+    return entry && entry->visible;
+}
+
+void OverlayLayer::setItemGeometry(OverlayItem *item, const QRect &rect)
+{
+    Entry *entry = find(item);
+    if (!entry || entry->rect == rect) return;
+    if (entry->visible) {
+        update(entry->rect);
+        update(rect);
+    }
+    if (entry->rect.size() != rect.size()) entry->cache = QPixmap();
+    entry->rect = rect;
+}
+
+void OverlayLayer::moveItem(OverlayItem *item, const QPoint &pos)
+{
+    const Entry *entry = find(item);
+    if (entry) setItemGeometry(item, QRect(pos, entry->rect.size()));
+}
+
+QRect OverlayLayer::itemGeometry(OverlayItem *item) const
+{
+    const Entry *entry = find(item);
+    return entry ? entry->rect : QRect();
+}
+
+void OverlayLayer::paintEvent(QPaintEvent *event)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    QPainter painter(this);
+    const qreal dpr = devicePixelRatioF();
+    QRegion drawn;
+    for (Entry &entry : m_entries) {
+        if (!entry.visible || entry.rect.isEmpty() || !event->region().intersects(entry.rect)) continue;
+
+        if (entry.cache.isNull() || entry.cache.devicePixelRatio() != dpr) {
+            QPixmap cache(entry.rect.size() * dpr);
+            cache.setDevicePixelRatio(dpr);
+            cache.fill(Qt::transparent);
+            QPainter itemPainter(&cache);
+            entry.item->paint(itemPainter, entry.rect.size());
+            itemPainter.end();
+            entry.cache = cache;
+        }
+        painter.drawPixmap(entry.rect.topLeft(), entry.cache);
+        drawn += event->region() & entry.rect;
+    }
+
+    // Canvas exposes reach this widget too, only count the ones that drew something
+    if (!drawn.isEmpty()) {
+        PaintTrace::instance()->record(PaintTrace::Overlay, drawn, timer.nsecsElapsed() / 1e6);
+    }
+}
+
+OverlayLayer::Entry *OverlayLayer::find(OverlayItem *item)
+{
+    for (Entry &entry : m_entries) {
+        if (entry.item == item) return &entry;
+    }
+    return nullptr;
+}
+
+const OverlayLayer::Entry *OverlayLayer::find(OverlayItem *item) const
+{
+    for (const Entry &entry : m_entries) {
+        if (entry.item == item) return &entry;
+    }
+    return nullptr;
+}
@@ -0,0 +1,78 @@
+#ifndef OVERLAYLAYER_H
+#define OVERLAYLAYER_H
+
+#include <QColor>
+#include <QList>
+#include <QObject>
+#include <QPixmap>
+#include <QWidget>
+
+// Something drawn over the image by an OverlayLayer. Items paint into a
+// cached pixmap of their own and emit changed() when it has to be redrawn.
+class OverlayItem : public QObject
+{
+    Q_OBJECT
+public:
+    explicit OverlayItem(QObject *parent = nullptr);
+
+    virtual QSize sizeHint() const = 0;
+    virtual void paint(QPainter &painter, const QSize &size) const = 0;
+
+signals:
+    void changed();
+};
+
+// Plain rounded plate, the backdrop behind the navigation HUD buttons
+class OverlayPanel : public OverlayItem
+{
+    Q_OBJECT
+public:
+    OverlayPanel(const QColor &color, qreal radius, QObject *parent = nullptr);
+
+    QSize sizeHint() const override;
+    void paint(QPainter &painter, const QSize &size) const override;
+
+private:
+    QColor m_color;
+    qreal m_radius;
+};
+
+// One transparent, mouse-transparent widget over the image that composites
+// every overlay item. Showing, moving or changing an item only invalidates
+// its old and new rectangle, and a paint blits just the cached items that
+// intersect the exposed region. The canvas below answers those small exposes
+// from its frame cache, so overlays never make the image rescale.
+// The layer itself stays shown: hiding a widget this size repaints all of it.
+class OverlayLayer : public QWidget
+{
+    Q_OBJECT
+public:
+    explicit OverlayLayer(QWidget *parent = nullptr);
+
+    // Items stack in the order they are added, hidden until shown
+    void addItem(OverlayItem *item);
+
+    void setItemVisible(OverlayItem *item, bool visible);
+    bool isItemVisible(OverlayItem *item) const;
+    void setItemGeometry(OverlayItem *item, const QRect &rect);
+    void moveItem(OverlayItem *item, const QPoint &pos);
+    QRect itemGeometry(OverlayItem *item) const;
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+
+private:
+    struct Entry {
+        OverlayItem *item = nullptr;
+        QRect rect;
+        bool visible = false;
+        QPixmap cache; // Null until painted, or after changed()
+    };
+
+    Entry *find(OverlayItem *item);
+    const Entry *find(OverlayItem *item) const;
+
+    QList<Entry> m_entries;
+};
+
+#endif // OVERLAYLAYER_H
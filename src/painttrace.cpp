@@ -0,0 +1,64 @@
+#include "painttrace.h"
+#include <QRegion>
+#include <QStringList>
+
+PaintTrace *PaintTrace::instance()
+{
+    static PaintTrace trace;
+    return &trace;
+}
+
+void PaintTrace::record(Layer layer, const QRegion &region, double ms)
+{
+    // Area actually asked for, not the bounding box: two small corners stay small
+    qint64 pixels = 0;
+    for (const QRect &rect : region) {
+        pixels += qint64(rect.width()) * rect.height();
+    }
+
+    Counters &c = m_counters[layer];
+    c.paints++;
+    c.pixels += pixels;
+    c.ms += ms;
+    c.lastPixels = pixels;
+    c.lastMs = ms;
+    c.maxPixels = qMax(c.maxPixels, pixels);
+}
+
+PaintTrace::Counters PaintTrace::counters(Layer layer) const
+{
+    return m_counters[layer];
+}
+
+void PaintTrace::reset()
+{
+    for (Counters &c : m_counters) {
+        c = Counters();
+    }
+}
+
+QString PaintTrace::summary() const
+{
+    QStringList parts;
+    for (int i = 0; i < LayerCount; ++i) {
+        const Counters &c = m_counters[i];
+        const qint64 averagePixels = c.paints > 0 ? c.pixels / c.paints : 0;
+        const double averageMs = c.paints > 0 ? c.ms / c.paints : 0.0;
+        parts << QString("%1: %2 paints, last %3 kpx in %4 ms, avg %5 kpx in %6 ms, max %7 kpx")
+            .arg(layerName(Layer(i))).arg(c.paints)
+            .arg(c.lastPixels / 1000).arg(c.lastMs, 0, 'f', 2)
+            .arg(averagePixels / 1000).arg(averageMs, 0, 'f', 2)
+            .arg(c.maxPixels / 1000);
+    }
+    return parts.join("  |  ");
+}
+
+QString PaintTrace::layerName(Layer layer)
+{
+    switch (layer) {
+    case Canvas: return "canvas";
+    case Overlay: return "overlay";
+    case LayerCount: break;
+    }
+    return QString();
+}
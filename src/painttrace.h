@@ -0,0 +1,45 @@
+#ifndef PAINTTRACE_H
+#define PAINTTRACE_H
+
+#include <QString>
+
+class QRegion;
+
+// Repaint counters per layer: how many pixels each paint event covered and
+// how long it took. Shown with F12 next to the scheduler counters, so it is
+// easy to see whether a HUD hover repainted a button or the whole image.
+// Painting only happens on the GUI thread, so no locking.
+class PaintTrace
+{
+public:
+    enum Layer {
+        Canvas,  // The image, including compare panes
+        Overlay, // HUD backdrop, histogram, loupe
+        LayerCount
+    };
+
+    struct Counters {
+        qint64 paints = 0;
+        qint64 pixels = 0;
+        double ms = 0.0;
+        qint64 lastPixels = 0;
+        double lastMs = 0.0;
+        qint64 maxPixels = 0; // Largest single paint, one full repaint hides in an average
+    };
+
+    static PaintTrace *instance();
+
+    void record(Layer layer, const QRegion &region, double ms);
+    Counters counters(Layer layer) const;
+    void reset();
+
+    QString summary() const;
+    static QString layerName(Layer layer);
+
+private:
+    PaintTrace() = default;
+
+    Counters m_counters[LayerCount];
+};
+
+#endif // PAINTTRACE_H
@@ -0,0 +1,114 @@
+#include "pixelloupe.h"
+#include <QFontMetrics>
+#include <QPainter>
+
+namespace {
+    constexpr int VIEW_SIDE = 160; // Magnified area, in screen pixels
+    constexpr int PADDING = 6;
+}
+
+PixelLoupe::PixelLoupe(QObject *parent)
+    : OverlayItem(parent)
+    , m_pixel(-1, -1)
+    , m_magnification(8)
+{
+}
+
+void PixelLoupe::setSource(const QImage &image)
+{
+    m_source = image;
+    m_pixel = QPoint(-1, -1);
+    emit changed();
+}
+
+void PixelLoupe::setPixel(const QPoint &pixel)
+{
+    if (pixel == m_pixel) return;
+    m_pixel = pixel;
+    emit changed();
+}
+
+QPoint PixelLoupe::pixel() const
+{
+    return m_pixel;
+}
+
+bool PixelLoupe::hasPixel() const
+{
+    return m_source.valid(m_pixel);
+}
+
+QColor PixelLoupe::color() const
+{
+    if (!hasPixel()) return QColor();
+    // Pyramid bases are premultiplied when they have alpha
+    return QColor::fromRgba(qUnpremultiply(m_source.pixel(m_pixel)));
+}
+
+void PixelLoupe::setMagnification(int magnification)
+{
+    m_magnification = qBound(MIN_MAGNIFICATION, magnification, MAX_MAGNIFICATION);
+    emit changed();
+}
+
+int PixelLoupe::magnification() const
+{
+    return m_magnification;
+}
+
+QSize PixelLoupe::sizeHint() const
+{
+    return QSize(VIEW_SIDE + 2 * PADDING, VIEW_SIDE + 2 * PADDING + 2 * QFontMetrics(QFont()).height());
+}
+
+void PixelLoupe::paint(QPainter &p, const QSize &size) const
+{
+    p.setRenderHint(QPainter::Antialiasing);
+    p.setPen(Qt::NoPen);
+    p.setBrush(QColor(0, 0, 0, 190));
+    p.drawRoundedRect(QRectF(QPointF(0, 0), QSizeF(size)), 10, 10);
+    p.setRenderHint(QPainter::Antialiasing, false);
+
+    const QRect view(PADDING, PADDING, VIEW_SIDE, VIEW_SIDE);
+    p.fillRect(view, QColor(30, 30, 30));
+    if (!hasPixel()) return;
+
+    // Odd number of source pixels, so the picked one sits in the middle
+    int span = VIEW_SIDE / m_magnification;
+    if (span % 2 == 0) span--;
+    span = qMax(1, span);
+    const int half = span / 2;
+    const QRect source(m_pixel.x() - half, m_pixel.y() - half, span, span);
+    const QRect clipped = source & m_source.rect();
+
+    // Nearest neighbor, pixels stay square
+    const QPoint origin = view.center() - QPoint(half * m_magnification + m_magnification / 2,
+                                                  half * m_magnification + m_magnification / 2);
+    const QRect target(origin + (clipped.topLeft() - source.topLeft()) * m_magnification,
+                       clipped.size() * m_magnification);
+    p.save();
+    p.setClipRect(view);
+    p.drawImage(target, m_source, clipped);
+
+    // Outline the picked pixel, light or dark depending on what is under it
+    const QColor picked = color();
+    const QRect cell(origin + QPoint(half, half) * m_magnification, QSize(m_magnification, m_magnification));
+    p.setPen(picked.lightness() > 128 ? Qt::black : Qt::white);
+    p.setBrush(Qt::NoBrush);
+    p.drawRect(cell.adjusted(-1, -1, 0, 0));
+    p.restore();
+
+    // Coordinates, then the value
+    const int lineHeight = p.fontMetrics().height();
+    QRect text(PADDING, view.bottom() + 1, VIEW_SIDE, lineHeight);
+    p.setPen(Qt::white);
+    p.drawText(text, Qt::AlignLeft | Qt::AlignVCenter,
+               QString("%1, %2").arg(m_pixel.x()).arg(m_pixel.y()));
+    p.drawText(text, Qt::AlignRight | Qt::AlignVCenter, QString("%1x").arg(m_magnification));
+
+    text.translate(0, lineHeight);
+    QString value = QString("%1 %2 %3").arg(picked.red()).arg(picked.green()).arg(picked.blue());
+    if (m_source.hasAlphaChannel()) value += QString(" a%1").arg(picked.alpha());
+    p.drawText(text, Qt::AlignLeft | Qt::AlignVCenter, value);
+    p.drawText(text, Qt::AlignRight | Qt::AlignVCenter, picked.name(QColor::HexRgb).toUpper());
+}
@@ -0,0 +1,39 @@
+#ifndef PIXELLOUPE_H
+#define PIXELLOUPE_H
+
+#include <QColor>
+#include <QImage>
+#include "overlaylayer.h"
+
+// Magnifier that follows the cursor. It samples a small window of the full
+// resolution decoded buffer around one source pixel and blows it up
+// (unfiltered, 1x to 16x) together with that pixel's coordinates and value.
+// A move costs one tiny drawImage, independent of image size and zoom level.
+class PixelLoupe : public OverlayItem
+{
+    Q_OBJECT
+public:
+    static constexpr int MIN_MAGNIFICATION = 1;
+    static constexpr int MAX_MAGNIFICATION = 16;
+
+    explicit PixelLoupe(QObject *parent = nullptr);
+
+    void setSource(const QImage &image); // RGB32 or ARGB32_Premultiplied
+    void setPixel(const QPoint &pixel);  // Source coordinates
+    QPoint pixel() const;
+    bool hasPixel() const;
+    QColor color() const;                // Unpremultiplied value under the cursor
+
+    void setMagnification(int magnification);
+    int magnification() const;
+
+    QSize sizeHint() const override;
+    void paint(QPainter &p, const QSize &size) const override;
+
+private:
+    QImage m_source;
+    QPoint m_pixel;
+    int m_magnification;
+};
+
+#endif // PIXELLOUPE_H
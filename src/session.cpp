@@ -0,0 +1,59 @@
+#include "session.h"
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+namespace {
+    constexpr quint32 SESSION_MAGIC = 0x4d565353; // "MVSS"
+    constexpr qint32 SESSION_VERSION = 1;
+}
+
+QString Session::filePath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/session.dat";
+}
+
+Session Session::load()
+{
+    Session session;
+    QFile file(filePath());
+    if (!file.open(QIODevice::ReadOnly)) return session;
+
+    QDataStream in(&file);
+    quint32 magic = 0;
+    qint32 version = 0;
+    qint32 count = 0;
+    qint32 current = -1;
+    in >> magic >> version >> count >> current;
+    if (magic != SESSION_MAGIC || version != SESSION_VERSION || count < 0) return session;
+    in >> session.windowGeometry;
+
+    for (qint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        Tab tab;
+        in >> tab.filePath >> tab.zoom >> tab.center;
+        session.tabs.append(tab);
+    }
+    if (in.status() != QDataStream::Ok) return Session(); // Truncated, start empty
+
+    session.currentTab = qBound(-1, int(current), int(session.tabs.size()) - 1);
+    return session;
+}
+
+bool Session::save() const
+{
+    const QString path = filePath();
+    QDir().mkpath(QFileInfo(path).absolutePath());
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) return false;
+    QDataStream out(&file);
+    out << SESSION_MAGIC << SESSION_VERSION << qint32(tabs.size()) << qint32(currentTab);
+    out << windowGeometry;
+    for (const Tab &tab : tabs) {
+        out << tab.filePath << tab.zoom << tab.center;
+    }
+    return file.commit();
+}
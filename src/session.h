@@ -0,0 +1,30 @@
+#ifndef SESSION_H
+#define SESSION_H
+
+#include <QByteArray>
+#include <QList>
+#include <QPointF>
+#include <QString>
+
+// Open tabs as they were when the window closed. Stored next to the other
+// per-user data as a small versioned QDataStream file, written atomically.
+struct Session
+{
+    struct Tab {
+        QString filePath;
+        double zoom = 1.0;                   // Relative to Fit, as in ImageTab
+        QPointF center = QPointF(0.5, 0.5);  // Viewport center as a fraction of the image
+    };
+
+    QList<Tab> tabs;
+    int currentTab = -1;
+    QByteArray windowGeometry; // QWidget::saveGeometry(), zoom is relative to the viewport
+
+    bool isEmpty() const { return tabs.isEmpty(); }
+
+    static Session load();
+    bool save() const;
+    static QString filePath();
+};
+
+#endif // SESSION_H
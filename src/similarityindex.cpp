@@ -0,0 +1,457 @@
+#include "similarityindex.h"
+#include "imagedecoder.h"
+#include "metadataindex.h"
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+namespace {
+    constexpr quint32 CACHE_MAGIC = 0x4d565048; // "MVPH"
+    constexpr qint32 CACHE_VERSION = 1;
+    // Files per scheduler task. Tasks yield between files when more urgent work
+    // is queued and hold the device slot only while reading a file, so visible
+    // work never waits for a decode, only for the worker or read in progress.
+    constexpr int CHUNK_SIZE = 16;
+    // Enough pixels for a meaningful sharpness estimate, small enough that
+    // JPEGs decode at 1/8 scale
+    constexpr int DECODE_SIDE = 256;
+    constexpr int DCT_SIZE = 32;
+    constexpr int DCT_KEEP = 8;
+    constexpr double PI = 3.14159265358979323846;
+
+    // Luma plane, same integer weights as the histogram
+    QVector<float> lumaPlane(const QImage &rgb)
+    {
+        QVector<float> plane(rgb.width() * rgb.height());
+        float *out = plane.data();
+        for (int y = 0; y < rgb.height(); ++y) {
+            const QRgb *line = reinterpret_cast<const QRgb *>(rgb.constScanLine(y));
+            for (int x = 0; x < rgb.width(); ++x) {
+                const QRgb p = line[x];
+                *out++ = float((qRed(p) * 77 + qGreen(p) * 150 + qBlue(p) * 29 + 128) >> 8);
+            }
+        }
+        return plane;
+    }
+
+    QVector<float> resizedLuma(const QImage &rgb, int width, int height)
+    {
+        // Smooth downscaling averages whole areas, a burst's small shifts wash out
+        return lumaPlane(rgb.scaled(width, height, Qt::IgnoreAspectRatio, Qt::SmoothTransformation)
+                             .convertToFormat(QImage::Format_RGB32));
+    }
+
+    float laplacianVariance(const QVector<float> &luma, int width, int height)
+    {
+        if (width < 3 || height < 3) return 0.0f;
+        double sum = 0.0;
+        double sumSquares = 0.0;
+        for (int y = 1; y < height - 1; ++y) {
+            const float *row = luma.constData() + y * width;
+            for (int x = 1; x < width - 1; ++x) {
+                const double l = 4.0 * row[x] - row[x - 1] - row[x + 1] - row[x - width] - row[x + width];
+                sum += l;
+                sumSquares += l * l;
+            }
+        }
+        const double n = double(width - 2) * (height - 2);
+        const double mean = sum / n;
+        return float(sumSquares / n - mean * mean);
+    }
+
+    quint64 differenceHash(const QVector<float> &luma)
+    {
+        // 9x8: each bit says whether brightness rises to the right
+        quint64 hash = 0;
+        for (int y = 0; y < 8; ++y) {
+            for (int x = 0; x < 8; ++x) {
+                if (luma.at(y * 9 + x) < luma.at(y * 9 + x + 1)) hash |= quint64(1) << (y * 8 + x);
+            }
+        }
+        return hash;
+    }
+
+    quint64 dctHash(const QVector<float> &luma)
+    {
+        // Only the lowest 8x8 frequencies of the 32x32 DCT-II are needed, computed separably
+        static const std::array<double, DCT_KEEP * DCT_SIZE> cosines = []() {
+            std::array<double, DCT_KEEP * DCT_SIZE> table{};
+            for (int u = 0; u < DCT_KEEP; ++u) {
+                for (int x = 0; x < DCT_SIZE; ++x) {
+                    table[u * DCT_SIZE + x] = std::cos((2 * x + 1) * u * PI / (2.0 * DCT_SIZE));
+                }
+            }
+            return table;
+        }();
+
+        double rows[DCT_SIZE][DCT_KEEP];
+        for (int y = 0; y < DCT_SIZE; ++y) {
+            for (int u = 0; u < DCT_KEEP; ++u) {
+                double sum = 0.0;
+                for (int x = 0; x < DCT_SIZE; ++x) sum += luma.at(y * DCT_SIZE + x) * cosines[u * DCT_SIZE + x];
+                rows[y][u] = sum;
+            }
+        }
+        std::array<double, DCT_KEEP * DCT_KEEP> coefficients{};
+        for (int v = 0; v < DCT_KEEP; ++v) {
+            for (int u = 0; u < DCT_KEEP; ++u) {
+                double sum = 0.0;
+                for (int y = 0; y < DCT_SIZE; ++y) sum += rows[y][u] * cosines[v * DCT_SIZE + y];
+                coefficients[v * DCT_KEEP + u] = sum;
+            }
+        }
+
+        // Median of the AC terms; the DC term is overall brightness and would skew it
+        std::array<double, DCT_KEEP * DCT_KEEP - 1> ac{};
+        std::copy(coefficients.begin() + 1, coefficients.end(), ac.begin());
+        std::nth_element(ac.begin(), ac.begin() + ac.size() / 2, ac.end());
+        const double median = ac[ac.size() / 2];
+
+        quint64 hash = 0;
+        for (int i = 0; i < DCT_KEEP * DCT_KEEP; ++i) {
+            if (coefficients[i] > median) hash |= quint64(1) << i;
+        }
+        return hash;
+    }
+
+    QString cacheFilePath(const QString &folder)
+    {
+        QString dir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/similarity";
+        QByteArray hash = QCryptographicHash::hash(folder.toUtf8(), QCryptographicHash::Sha1).toHex();
+        return dir + "/" + QString::fromLatin1(hash) + ".idx";
+    }
+
+    QDataStream &operator<<(QDataStream &out, const ImageHash &hash)
+    {
+        return out << hash.path << hash.fileSize << hash.modified << hash.dHash << hash.pHash
+                   << hash.sharpness << hash.hashed;
+    }
+
+    QDataStream &operator>>(QDataStream &in, ImageHash &hash)
+    {
+        return in >> hash.path >> hash.fileSize >> hash.modified >> hash.dHash >> hash.pHash
+                  >> hash.sharpness >> hash.hashed;
+    }
+
+    QHash<QString, ImageHash> loadCache(const QString &folder)
+    {
+        QHash<QString, ImageHash> entries;
+        QFile file(cacheFilePath(folder));
+        if (!file.open(QIODevice::ReadOnly)) return entries;
+
+        QDataStream in(&file);
+        quint32 magic = 0;
+        qint32 version = 0;
+        qint32 count = 0;
+        in >> magic >> version >> count;
+        if (magic != CACHE_MAGIC || version != CACHE_VERSION || count < 0) return entries;
+
+        entries.reserve(count);
+        for (qint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+            ImageHash hash;
+            in >> hash;
+            entries.insert(hash.path, hash);
+        }
+        if (in.status() != QDataStream::Ok) entries.clear(); // Truncated, start over
+        return entries;
+    }
+
+    void saveCache(const QString &folder, const QHash<QString, ImageHash> &entries)
+    {
+        QString path = cacheFilePath(folder);
+        QDir().mkpath(QFileInfo(path).absolutePath());
+
+        QSaveFile file(path);
+        if (!file.open(QIODevice::WriteOnly)) return;
+        QDataStream out(&file);
+        out << CACHE_MAGIC << CACHE_VERSION << qint32(entries.size());
+        for (const ImageHash &hash : entries) {
+            out << hash;
+        }
+        file.commit();
+    }
+
+    struct CacheLookup {
+        QList<ImageHash> current;
+        QFileInfoList stale;
+        int cachedCount = 0;
+    };
+
+    struct ChunkResult {
+        QList<ImageHash> hashed;
+        QFileInfoList rest; // Not hashed yet, the task yielded its worker
+    };
+
+    // Splits the listing into hashes still valid in the disk cache and files to decode
+    CacheLookup lookupCache(const QString &folder, const QFileInfoList &files)
+    {
+        QHash<QString, ImageHash> cached = loadCache(folder);
+        CacheLookup lookup;
+        lookup.cachedCount = cached.size();
+        lookup.current.reserve(files.size());
+
+        for (const QFileInfo &info : files) {
+            auto it = cached.constFind(info.absoluteFilePath());
+            qint64 size = 0;
+            qint64 modified = 0;
+            if (it != cached.constEnd()) MetadataIndex::fileStamp(info, &size, &modified);
+            if (it != cached.constEnd() && it->fileSize == size && it->modified == modified) {
+                lookup.current.append(it.value());
+            } else {
+                lookup.stale.append(info);
+            }
+        }
+        return lookup;
+    }
+}
+
+SimilarityIndex::SimilarityIndex(QObject *parent)
+    : QObject(parent)
+    , m_ready(false)
+    , m_fileCount(0)
+    , m_remainingChunks(0)
+    , m_cacheDirty(false)
+{
+}
+
+SimilarityIndex::~SimilarityIndex()
+{
+    cancel();
+}
+
+ImageHash SimilarityIndex::compute(const QFileInfo &info)
+{
+    bool ok = false;
+    const QByteArray data = ImageDecoder::readSource(info.absoluteFilePath(), &ok);
+    return compute(info, ok ? data : QByteArray());
+}
+
+ImageHash SimilarityIndex::compute(const QFileInfo &info, const QByteArray &data)
+{
+    DecodedImage::Error error = DecodedImage::NoError;
+    QImage image;
+    if (!data.isEmpty()) {
+        image = ImageDecoder::decodeToFit(info.absoluteFilePath(), data, QSize(DECODE_SIDE, DECODE_SIDE), &error);
+    }
+
+    ImageHash hash = computeFromImage(image);
+    hash.path = info.absoluteFilePath();
+    MetadataIndex::fileStamp(info, &hash.fileSize, &hash.modified);
+    return hash;
+}
+
+ImageHash SimilarityIndex::computeFromImage(const QImage &image)
+{
+    ImageHash hash;
+    if (image.isNull()) return hash;
+
+    // Transparent areas come out black, the same for every image
+    QImage rgb = image;
+    if (rgb.width() > DECODE_SIDE || rgb.height() > DECODE_SIDE) {
+        rgb = rgb.scaled(DECODE_SIDE, DECODE_SIDE, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    }
+    rgb = rgb.convertToFormat(QImage::Format_ARGB32_Premultiplied).convertToFormat(QImage::Format_RGB32);
+
+    hash.sharpness = laplacianVariance(lumaPlane(rgb), rgb.width(), rgb.height());
+    hash.dHash = differenceHash(resizedLuma(rgb, 9, 8));
+    hash.pHash = dctHash(resizedLuma(rgb, DCT_SIZE, DCT_SIZE));
+    hash.hashed = true;
+    return hash;
+}
+
+bool SimilarityIndex::isSimilar(const ImageHash &a, const ImageHash &b)
+{
+    // Both have to agree: dHash follows edges, pHash the overall layout
+    return a.hashed && b.hashed
+        && qPopulationCount(a.dHash ^ b.dHash) <= DHASH_THRESHOLD
+        && qPopulationCount(a.pHash ^ b.pHash) <= PHASH_THRESHOLD;
+}
+
+void SimilarityIndex::cancel()
+{
+    for (TaskHandle &task : m_tasks) {
+        task.cancel();
+    }
+    m_tasks.clear();
+    m_remainingChunks = 0;
+
+    // Big folders take minutes the first time, keep what was hashed so far
+    if (!m_ready && m_cacheDirty && !m_entries.isEmpty()) {
+        saveInBackground();
+    }
+    m_cacheDirty = false;
+}
+
+void SimilarityIndex::index(const QString &folder, const QFileInfoList &files)
+{
+    cancel();
+    m_ready = false;
+    m_entries.clear();
+    m_folder = folder;
+    m_fileCount = int(files.size());
+
+    // Cache lookup first, then reduced decodes in chunks, all at Background priority.
+    // The lookup counts as pending work until its chunks are queued.
+    m_remainingChunks = 1;
+    m_tasks << TaskScheduler::instance()->submit<CacheLookup>(TaskScheduler::Background, folder, this,
+        [folder, files](const TaskContext &) { return lookupCache(folder, files); },
+        [this](const CacheLookup &lookup) { onCacheLoaded(lookup.current, lookup.stale, lookup.cachedCount); });
+}
+
+void SimilarityIndex::clear()
+{
+    cancel();
+    m_ready = false;
+    m_entries.clear();
+    m_folder.clear();
+    m_fileCount = 0;
+}
+
+void SimilarityIndex::update(const QFileInfoList &added, const QStringList &removed)
+{
+    // Not indexing yet, index() gets the current listing
+    if (m_folder.isEmpty()) return;
+
+    for (const QString &path : removed) {
+        if (m_entries.remove(path) > 0) {
+            m_cacheDirty = true;
+            m_fileCount--;
+        }
+    }
+    if (added.isEmpty()) {
+        // Nothing to hash; finish() saves later if an index run is still going
+        if (m_remainingChunks == 0 && m_cacheDirty) finish();
+        return;
+    }
+
+    for (const QFileInfo &info : added) {
+        if (!m_entries.contains(info.absoluteFilePath())) m_fileCount++;
+    }
+    m_cacheDirty = true;
+    hashInBackground(added);
+}
+
+void SimilarityIndex::onCacheLoaded(const QList<ImageHash> &current, const QFileInfoList &stale, int cachedCount)
+{
+    m_entries.reserve(current.size() + stale.size());
+    for (const ImageHash &hash : current) {
+        // Files updated while the lookup ran are already fresher
+        if (!m_entries.contains(hash.path)) m_entries.insert(hash.path, hash);
+    }
+    // Rewrite the disk cache when something gets hashed or files disappeared
+    m_cacheDirty |= !stale.isEmpty() || current.size() != cachedCount;
+
+    hashInBackground(stale);
+    if (--m_remainingChunks == 0) {
+        finish();
+    } else {
+        emit progress(int(m_entries.size()), m_fileCount);
+    }
+}
+
+void SimilarityIndex::hashInBackground(const QFileInfoList &files)
+{
+    for (int start = 0; start < files.size(); start += CHUNK_SIZE) {
+        QFileInfoList chunk = files.mid(start, CHUNK_SIZE);
+        m_remainingChunks++;
+        m_tasks << TaskScheduler::instance()->submit<ChunkResult>(TaskScheduler::Background, m_folder, this,
+            [chunk](const TaskContext &ctx) {
+                ChunkResult result;
+                result.hashed.reserve(chunk.size());
+                for (int i = 0; i < chunk.size(); ++i) {
+                    if (i > 0) {
+                        // More urgent work waits for this worker or device: hand it over
+                        if (ctx.shouldYield()) {
+                            result.rest = chunk.mid(i);
+                            break;
+                        }
+                        if (!ctx.acquireIo()) break; // Cancelled
+                    }
+                    // Only the read counts against the device limit, hashing is CPU work
+                    bool ok = false;
+                    const QByteArray data = ImageDecoder::readSource(chunk.at(i).absoluteFilePath(), &ok);
+                    ctx.releaseIo();
+                    result.hashed.append(compute(chunk.at(i), ok ? data : QByteArray()));
+                }
+                return result;
+            },
+            [this](const ChunkResult &result) { onChunkHashed(result.hashed, result.rest); });
+    }
+}
+
+void SimilarityIndex::onChunkHashed(const QList<ImageHash> &chunk, const QFileInfoList &rest)
+{
+    for (const ImageHash &hash : chunk) {
+        m_entries.insert(hash.path, hash);
+    }
+    // Back to the end of the Background queue, behind whatever preempted it
+    hashInBackground(rest);
+    if (--m_remainingChunks == 0) {
+        finish();
+    } else {
+        emit progress(int(m_entries.size()), m_fileCount);
+    }
+}
+
+void SimilarityIndex::finish()
+{
+    m_tasks.clear();
+    m_ready = true;
+
+    if (m_cacheDirty) {
+        saveInBackground();
+        m_cacheDirty = false;
+    }
+    emit ready();
+}
+
+void SimilarityIndex::saveInBackground()
+{
+    QString folder = m_folder;
+    QHash<QString, ImageHash> entries = m_entries;
+    TaskScheduler::instance()->submit(TaskScheduler::Background, folder, [folder, entries](const TaskContext &) {
+        saveCache(folder, entries);
+    });
+}
+
+bool SimilarityIndex::isReady() const
+{
+    return m_ready;
+}
+
+int SimilarityIndex::hashedCount() const
+{
+    return int(m_entries.size());
+}
+
+int SimilarityIndex::fileCount() const
+{
+    return m_fileCount;
+}
+
+ImageHash SimilarityIndex::hash(const QString &path) const
+{
+    return m_entries.value(path);
+}
+
+QVector<int> SimilarityIndex::groups(const QStringList &order) const
+{
+    // Bursts are shot back to back, so only neighbours are compared: linear in
+    // the folder size, and a slowly drifting pan stays one burst
+    QVector<int> result(order.size());
+    int group = -1;
+    ImageHash previous;
+    for (int i = 0; i < order.size(); ++i) {
+        ImageHash current = m_entries.value(order.at(i));
+        if (i == 0 || !isSimilar(previous, current)) group++;
+        result[i] = group;
+        previous = current;
+    }
+    return result;
+}
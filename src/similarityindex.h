@@ -0,0 +1,83 @@
+#ifndef SIMILARITYINDEX_H
+#define SIMILARITYINDEX_H
+
+#include <QObject>
+#include <QFileInfo>
+#include <QHash>
+#include <QImage>
+#include <QVector>
+#include "taskscheduler.h"
+
+// Perceptual fingerprint of one image, from a small decode
+struct ImageHash
+{
+    QString path;
+    qint64 fileSize = 0;
+    qint64 modified = 0;    // Same staleness check as ImageMetadata
+    quint64 dHash = 0;      // 9x8 horizontal gradient signs
+    quint64 pHash = 0;      // Low 8x8 DCT coefficients of a 32x32 thumbnail, against their median
+    float sharpness = 0.0f; // Laplacian variance, higher is crisper; picks the best of a burst
+    bool hashed = false;    // False when the file could not be decoded
+
+    bool isValid() const { return !path.isEmpty() && hashed; }
+};
+
+// Background indexer for one folder that finds bursts: runs of near-identical
+// shots next to each other in navigation order. Each image is decoded straight
+// to a 256 px thumbnail (JPEG DCT scaling keeps that cheap) in chunks of
+// Background priority scheduler tasks, spread over all workers. Results are
+// kept in an on-disk cache keyed by path + mtime, like MetadataIndex, so only
+// new or changed files are ever decoded again.
+class SimilarityIndex : public QObject
+{
+    Q_OBJECT
+public:
+    // Hamming distances (of 64 bits) up to which two shots count as the same scene
+    static constexpr int DHASH_THRESHOLD = 12;
+    static constexpr int PHASH_THRESHOLD = 10;
+
+    explicit SimilarityIndex(QObject *parent = nullptr);
+    ~SimilarityIndex();
+
+    static ImageHash compute(const QFileInfo &info);
+    // Same, from the file contents already read
+    static ImageHash compute(const QFileInfo &info, const QByteArray &data);
+    static ImageHash computeFromImage(const QImage &image);
+    static bool isSimilar(const ImageHash &a, const ImageHash &b);
+
+    void index(const QString &folder, const QFileInfoList &files);
+    // Drops the folder, e.g. while a new one waits for its header pass
+    void clear();
+    // Live folders: hashes only the added (or rewritten) files, emits ready() again when done
+    void update(const QFileInfoList &added, const QStringList &removed);
+    bool isReady() const;
+    int hashedCount() const;
+    int fileCount() const;
+    ImageHash hash(const QString &path) const;
+
+    // Burst number for every position of order. Neighbours share a number while
+    // they stay similar; unhashed files are bursts of their own.
+    QVector<int> groups(const QStringList &order) const;
+
+signals:
+    void progress(int hashed, int total);
+    void ready();
+
+private:
+    void cancel();
+    void onCacheLoaded(const QList<ImageHash> &current, const QFileInfoList &stale, int cachedCount);
+    void hashInBackground(const QFileInfoList &files);
+    void onChunkHashed(const QList<ImageHash> &chunk, const QFileInfoList &rest);
+    void finish();
+    void saveInBackground();
+
+    QString m_folder;
+    QHash<QString, ImageHash> m_entries;
+    QList<TaskHandle> m_tasks;
+    bool m_ready;
+    int m_fileCount;
+    int m_remainingChunks;
+    bool m_cacheDirty;
+};
+
+#endif // SIMILARITYINDEX_H
@@ -0,0 +1,423 @@
+#include "taskscheduler.h"
+#include <QCoreApplication>
+#include <QFile>
+#include <QFileInfo>
+#include <QThread>
+#ifdef Q_OS_UNIX
+#include <sys/stat.h>
+#endif
+#ifdef Q_OS_LINUX
+#include <sys/sysmacros.h>
+#endif
+
+namespace {
+    // Concurrent readers per device
+    constexpr int SSD_IO_LIMIT = 4;
+    constexpr int ROTATIONAL_IO_LIMIT = 1;
+}
+
+struct TaskState
+{
+    TaskScheduler::Work work;
+    QAtomicInt cancelled;
+    int priority = TaskScheduler::Background;
+    quint64 device = 0; // 0: no I/O limit applies
+    int ioLimit = 0;
+    bool started = false;
+    bool holdsIo = false; // Counted in the device's reads in flight
+};
+
+// TaskHandle
+
+TaskHandle::TaskHandle()
+{
+}
+
+TaskHandle::TaskHandle(const QSharedPointer<TaskState> &state)
+    : m_state(state)
+{
+}
+
+bool TaskHandle::isValid() const
+{
+    return !m_state.isNull();
+}
+
+bool TaskHandle::isCancelled() const
+{
+    return m_state && m_state->cancelled.loadRelaxed();
+}
+
+void TaskHandle::cancel()
+{
+    if (!m_state) return;
+    if (m_state->cancelled.testAndSetRelaxed(0, 1)) {
+        TaskScheduler::instance()->cancelPending(m_state);
+    }
+}
+
+void TaskHandle::setPriority(int priority)
+{
+    if (!m_state) return;
+    TaskScheduler::instance()->reprioritize(m_state, priority);
+}
+
+// TaskContext
+
+TaskContext::TaskContext(const TaskScheduler *scheduler, const QSharedPointer<TaskState> &state)
+    : m_scheduler(scheduler)
+    , m_state(state)
+{
+}
+
+bool TaskContext::isCancelled() const
+{
+    return m_state->cancelled.loadRelaxed();
+}
+
+bool TaskContext::shouldYield() const
+{
+    if (isCancelled()) return true;
+    QMutexLocker lock(&m_scheduler->m_mutex);
+    return m_scheduler->hasUrgentWork(*m_state);
+}
+
+void TaskContext::releaseIo() const
+{
+    const_cast<TaskScheduler *>(m_scheduler)->releaseIo(*m_state);
+}
+
+bool TaskContext::acquireIo() const
+{
+    return const_cast<TaskScheduler *>(m_scheduler)->acquireIo(*m_state);
+}
+
+TaskHandle TaskContext::handle() const
+{
+    return TaskHandle(m_state);
+}
+
+// TaskScheduler
+
+TaskScheduler::TaskScheduler(QObject *parent)
+    : QObject(parent)
+    , m_stopping(false)
+{
+    for (int i = 0; i < PriorityCount; ++i) m_running[i] = 0;
+
+    const int workers = qMax(2, QThread::idealThreadCount());
+    m_counters.workers = workers;
+    for (int i = 0; i < workers; ++i) {
+        QThread *thread = QThread::create([this]() { workerLoop(); });
+        thread->setObjectName(QString("myview-worker-%1").arg(i));
+        thread->start();
+        m_threads.append(thread);
+    }
+}
+
+TaskScheduler::~TaskScheduler()
+{
+    {
+        QMutexLocker lock(&m_mutex);
+        m_stopping = true;
+        for (auto &queue : m_queues) {
+            for (const auto &task : queue) task->cancelled.storeRelaxed(1);
+            queue.clear();
+        }
+        // Running chunks stop at their next file instead of finishing the whole task
+        for (const auto &task : std::as_const(m_runningTasks)) task->cancelled.storeRelaxed(1);
+        m_wakeup.wakeAll();
+    }
+    for (QThread *thread : m_threads) {
+        thread->wait();
+        delete thread;
+    }
+}
+
+TaskScheduler *TaskScheduler::instance()
+{
+    // Parented to the application so the workers are joined before it goes away
+    static TaskScheduler *scheduler = new TaskScheduler(QCoreApplication::instance());
+    return scheduler;
+}
+
+QString TaskScheduler::priorityName(Priority priority)
+{
+    switch (priority) {
+    case Visible: return "visible";
+    case Prefetch: return "prefetch";
+    case HiddenTab: return "hidden";
+    case Background: return "background";
+    case PriorityCount: break;
+    }
+    return QString();
+}
+
+TaskHandle TaskScheduler::submit(Priority priority, const QString &ioPath, Work work)
+{
+    QSharedPointer<TaskState> state(new TaskState);
+    state->work = std::move(work);
+    state->priority = priority;
+    if (!ioPath.isEmpty()) {
+        const Device device = deviceFor(ioPath);
+        state->device = device.id;
+        state->ioLimit = device.ioLimit;
+    }
+
+    QMutexLocker lock(&m_mutex);
+    m_queues[priority].push_back(state);
+    m_counters.submitted[priority]++;
+    m_wakeup.wakeOne();
+    return TaskHandle(state);
+}
+
+void TaskScheduler::cancelPending(const QSharedPointer<TaskState> &state)
+{
+    QMutexLocker lock(&m_mutex);
+    if (state->started) {
+        // Running tasks notice through their context, or in acquireIo()
+        m_wakeup.wakeAll();
+        return;
+    }
+    auto &queue = m_queues[state->priority];
+    for (auto it = queue.begin(); it != queue.end(); ++it) {
+        if (*it == state) {
+            queue.erase(it);
+            m_counters.cancelled[state->priority]++;
+            return;
+        }
+    }
+}
+
+void TaskScheduler::reprioritize(const QSharedPointer<TaskState> &state, int priority)
+{
+    if (priority < 0 || priority >= PriorityCount) return;
+
+    QMutexLocker lock(&m_mutex);
+    if (state->priority == priority) return;
+    if (state->started) {
+        // Only affects shouldYield() from here on
+        state->priority = priority;
+        return;
+    }
+
+    auto &from = m_queues[state->priority];
+    for (auto it = from.begin(); it != from.end(); ++it) {
+        if (*it == state) {
+            from.erase(it);
+            state->priority = priority;
+            m_queues[priority].push_back(state);
+            m_wakeup.wakeOne();
+            return;
+        }
+    }
+}
+
+bool TaskScheduler::workerAvailable(int priority) const
+{
+    int busy = 0;
+    for (int i = 0; i < PriorityCount; ++i) busy += m_running[i];
+    if (busy >= m_threads.size()) return false;
+    // Keep one worker free for on-screen work
+    return priority == Visible || m_threads.size() == 1 || busy < m_threads.size() - 1;
+}
+
+bool TaskScheduler::ioAvailable(const TaskState &task) const
+{
+    return task.device == 0 || m_ioInFlight.value(task.device) < task.ioLimit;
+}
+
+bool TaskScheduler::canStart(const QSharedPointer<TaskState> &task, int priority) const
+{
+    return workerAvailable(priority) && ioAvailable(*task);
+}
+
+bool TaskScheduler::hasUrgentWork(const TaskState &current) const
+{
+    // A task of a higher class is queued and cannot start: no worker it may
+    // use is free, or it reads from the device this task holds a slot on
+    for (int i = 0; i < current.priority; ++i) {
+        const auto &queue = m_queues[i];
+        if (queue.empty()) continue;
+        if (!workerAvailable(i)) return true;
+        if (!current.holdsIo) continue;
+        for (const auto &task : queue) {
+            if (task->device == current.device && !ioAvailable(*task)) return true;
+        }
+    }
+    return false;
+}
+
+bool TaskScheduler::ioWantedByUrgentWork(const TaskState &current) const
+{
+    // Queued work of a higher class for the same device, which a free worker
+    // would start as soon as a slot opens. Work that has no worker to run on
+    // does not count, or every worker could end up waiting here for it.
+    for (int i = 0; i < current.priority; ++i) {
+        if (!workerAvailable(i)) continue;
+        for (const auto &task : m_queues[i]) {
+            if (task->device == current.device) return true;
+        }
+    }
+    return false;
+}
+
+void TaskScheduler::releaseIo(TaskState &state)
+{
+    QMutexLocker lock(&m_mutex);
+    if (!state.holdsIo) return;
+    state.holdsIo = false;
+    m_ioInFlight[state.device]--;
+    m_wakeup.wakeAll();
+}
+
+bool TaskScheduler::acquireIo(TaskState &state)
+{
+    QMutexLocker lock(&m_mutex);
+    if (state.device == 0 || state.holdsIo) return !state.cancelled.loadRelaxed();
+    while (!m_stopping && !state.cancelled.loadRelaxed()
+           && (!ioAvailable(state) || ioWantedByUrgentWork(state))) {
+        m_wakeup.wait(&m_mutex);
+    }
+    if (m_stopping || state.cancelled.loadRelaxed()) return false;
+    state.holdsIo = true;
+    m_ioInFlight[state.device]++;
+    return true;
+}
+
+bool TaskScheduler::takeNext(QSharedPointer<TaskState> *task)
+{
+    for (int priority = 0; priority < PriorityCount; ++priority) {
+        auto &queue = m_queues[priority];
+        for (auto it = queue.begin(); it != queue.end(); ++it) {
+            if (canStart(*it, priority)) {
+                *task = *it;
+                queue.erase(it);
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void TaskScheduler::workerLoop()
+{
+    QMutexLocker lock(&m_mutex);
+    forever {
+        QSharedPointer<TaskState> task;
+        while (!m_stopping && !takeNext(&task)) {
+            m_wakeup.wait(&m_mutex);
+        }
+        if (m_stopping) return;
+
+        const int priority = task->priority;
+        task->started = true;
+        m_running[priority]++;
+        m_runningTasks.append(task);
+        if (task->device != 0) {
+            task->holdsIo = true;
+            m_ioInFlight[task->device]++;
+        }
+
+        lock.unlock();
+        if (!task->cancelled.loadRelaxed()) {
+            task->work(TaskContext(this, task));
+        }
+        task->work = nullptr; // Release captures on the worker, not on whoever drops the last handle
+        lock.relock();
+
+        m_running[priority]--;
+        m_runningTasks.removeOne(task);
+        if (task->holdsIo) {
+            task->holdsIo = false;
+            m_ioInFlight[task->device]--;
+        }
+        if (task->cancelled.loadRelaxed()) {
+            m_counters.cancelled[priority]++;
+        } else {
+            m_counters.completed[priority]++;
+        }
+        // A worker and possibly an I/O slot just freed up
+        m_wakeup.wakeAll();
+    }
+}
+
+TaskScheduler::Device TaskScheduler::deviceFor(const QString &path)
+{
+    // stat() once per directory, never under m_mutex
+    QFileInfo info(path);
+    QString dir = info.isDir() ? info.absoluteFilePath() : info.absolutePath();
+    {
+        QMutexLocker lock(&m_deviceMutex);
+        auto it = m_deviceByDir.constFind(dir);
+        if (it != m_deviceByDir.constEnd()) {
+            Device device = it.value();
+            device.ioLimit = m_ioLimitOverride.value(device.id, device.ioLimit);
+            return device;
+        }
+    }
+
+    Device device;
+    device.id = 1; // Unknown: all such paths share one limit
+#ifdef Q_OS_UNIX
+    struct stat st;
+    if (::stat(QFile::encodeName(dir).constData(), &st) == 0) {
+        device.id = quint64(st.st_dev) + 1;
+    }
+#endif
+    device.ioLimit = ioLimitFor(device.id);
+
+    // Two threads resolving the same folder at once store the same answer
+    QMutexLocker lock(&m_deviceMutex);
+    m_deviceByDir.insert(dir, device);
+    device.ioLimit = m_ioLimitOverride.value(device.id, device.ioLimit);
+    return device;
+}
+
+void TaskScheduler::setIoLimit(const QString &path, int limit)
+{
+    const Device device = deviceFor(path);
+    QMutexLocker lock(&m_deviceMutex);
+    m_ioLimitOverride.insert(device.id, qMax(1, limit));
+}
+
+int TaskScheduler::ioLimitFor(quint64 device)
+{
+#ifdef Q_OS_LINUX
+    // Partitions have no queue/ of their own, the parent disk does
+    dev_t dev = dev_t(device - 1);
+    QString base = QString("/sys/dev/block/%1:%2").arg(major(dev)).arg(minor(dev));
+    for (const QString &candidate : {base + "/queue/rotational", base + "/../queue/rotational"}) {
+        QFile file(candidate);
+        if (file.open(QIODevice::ReadOnly)) {
+            return file.readAll().trimmed() == "1" ? ROTATIONAL_IO_LIMIT : SSD_IO_LIMIT;
+        }
+    }
+#else
+    Q_UNUSED(device);
+#endif
+    return SSD_IO_LIMIT;
+}
+
+TaskScheduler::Counters TaskScheduler::counters() const
+{
+    QMutexLocker lock(&m_mutex);
+    Counters result = m_counters;
+    for (int i = 0; i < PriorityCount; ++i) {
+        result.pending[i] = int(m_queues[i].size());
+        result.running[i] = m_running[i];
+    }
+    return result;
+}
+
+QString TaskScheduler::summary() const
+{
+    Counters c = counters();
+    QStringList parts;
+    for (int i = 0; i < PriorityCount; ++i) {
+        parts << QString("%1: %2 running, %3 queued, %4 done, %5 cancelled")
+            .arg(priorityName(Priority(i)))
+            .arg(c.running[i]).arg(c.pending[i]).arg(c.completed[i]).arg(c.cancelled[i]);
+    }
+    return QString("Workers: %1  |  ").arg(c.workers) + parts.join("  |  ");
+}
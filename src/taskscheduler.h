@@ -0,0 +1,178 @@
+#ifndef TASKSCHEDULER_H
+#define TASKSCHEDULER_H
+
+#include <QObject>
+#include <QHash>
+#include <QMutex>
+#include <QPointer>
+#include <QSharedPointer>
+#include <QWaitCondition>
+#include <deque>
+#include <functional>
+
+class QThread;
+struct TaskState;
+class TaskContext;
+class TaskScheduler;
+
+// Handle to a submitted task. Cheap to copy; an invalid (default) handle is a no-op.
+class TaskHandle
+{
+public:
+    TaskHandle();
+
+    bool isValid() const;
+    bool isCancelled() const;
+    // Pending tasks never start, running ones see TaskContext::isCancelled()
+    void cancel();
+    void setPriority(int priority); // A TaskScheduler::Priority
+
+private:
+    friend class TaskScheduler;
+    explicit TaskHandle(const QSharedPointer<TaskState> &state);
+    QSharedPointer<TaskState> m_state;
+};
+
+// Passed to running work. Long jobs should poll it between units of work.
+class TaskContext
+{
+public:
+    bool isCancelled() const;
+    // Cancelled, or more urgent work cannot start until this task gives up its
+    // worker or its I/O slot
+    bool shouldYield() const;
+    TaskHandle handle() const;
+
+    // Tasks submitted with an ioPath start holding a slot on its device. Work
+    // that reads and then computes hands it back once the bytes are in memory,
+    // and takes it again before the next read. acquireIo() blocks, lets queued
+    // work of a higher class go first, and returns false once cancelled.
+    void releaseIo() const;
+    bool acquireIo() const;
+
+private:
+    friend class TaskScheduler;
+    TaskContext(const TaskScheduler *scheduler, const QSharedPointer<TaskState> &state);
+    const TaskScheduler *m_scheduler;
+    QSharedPointer<TaskState> m_state;
+};
+
+// One worker pool for all decode, prefetch, render and indexing work of the
+// process, so background jobs can never starve what is on screen.
+//  - Strict priority classes; within a class tasks run in submission order.
+//  - One worker is held back for Visible work whenever there is more than one.
+//  - Tasks that read files name a path; reads on the same block device are
+//    limited to a few at a time (one for rotational disks). The slot is only
+//    held while reading, decoding runs unthrottled on every worker.
+//  - Running background work yields between files when a more urgent task is
+//    blocked on its worker or its device, so on-screen work waits for at most
+//    one file read.
+//  - Pending tasks can be cancelled or re-prioritized (tabs being hidden).
+class TaskScheduler : public QObject
+{
+    Q_OBJECT
+public:
+    enum Priority {
+        Visible,     // What is on screen right now
+        Prefetch,    // Neighbors of the visible image
+        HiddenTab,   // Work on behalf of tabs that are not shown
+        Background,  // Thumbnails, metadata indexing
+        PriorityCount
+    };
+
+    struct Counters {
+        qint64 submitted[PriorityCount] = {};
+        qint64 completed[PriorityCount] = {};
+        qint64 cancelled[PriorityCount] = {};
+        int pending[PriorityCount] = {};
+        int running[PriorityCount] = {};
+        int workers = 0;
+    };
+
+    using Work = std::function<void(const TaskContext &)>;
+
+    static TaskScheduler *instance();
+    ~TaskScheduler();
+
+    // ioPath: file or folder the task reads, empty for CPU only work
+    TaskHandle submit(Priority priority, const QString &ioPath, Work work);
+
+    // Runs work on a worker and hands the result to done on the GUI thread,
+    // unless the task was cancelled or context has been destroyed meanwhile.
+    template <typename Result>
+    TaskHandle submit(Priority priority, const QString &ioPath, QObject *context,
+                      std::function<Result(const TaskContext &)> work,
+                      std::function<void(const Result &)> done);
+
+    // Overrides the detected concurrent reads for path's device, e.g. for a
+    // network mount. Applies to tasks submitted from now on.
+    void setIoLimit(const QString &path, int limit);
+
+    Counters counters() const;
+    QString summary() const;
+
+    static QString priorityName(Priority priority);
+
+private:
+    friend class TaskHandle;
+    friend class TaskContext;
+
+    explicit TaskScheduler(QObject *parent = nullptr);
+
+    void workerLoop();
+    bool takeNext(QSharedPointer<TaskState> *task);
+    bool workerAvailable(int priority) const;
+    bool ioAvailable(const TaskState &task) const;
+    bool canStart(const QSharedPointer<TaskState> &task, int priority) const;
+    bool hasUrgentWork(const TaskState &current) const;
+    bool ioWantedByUrgentWork(const TaskState &current) const;
+    void reprioritize(const QSharedPointer<TaskState> &state, int priority);
+    void cancelPending(const QSharedPointer<TaskState> &state);
+    void releaseIo(TaskState &state);
+    bool acquireIo(TaskState &state);
+
+    struct Device {
+        quint64 id = 0; // 0: no I/O limit applies
+        int ioLimit = 0;
+    };
+    Device deviceFor(const QString &path);
+    static int ioLimitFor(quint64 device);
+
+    mutable QMutex m_mutex;
+    QWaitCondition m_wakeup;
+    QList<QThread *> m_threads;
+    bool m_stopping;
+
+    std::deque<QSharedPointer<TaskState>> m_queues[PriorityCount];
+    QList<QSharedPointer<TaskState>> m_runningTasks; // Marked cancelled on shutdown
+    int m_running[PriorityCount];
+    Counters m_counters;
+    QHash<quint64, int> m_ioInFlight;
+
+    // stat() and /sys reads can block on slow mounts, so they happen outside
+    // m_mutex; this one only guards the per-folder cache
+    QMutex m_deviceMutex;
+    QHash<QString, Device> m_deviceByDir;
+    QHash<quint64, int> m_ioLimitOverride;
+};
+
+template <typename Result>
+TaskHandle TaskScheduler::submit(Priority priority, const QString &ioPath, QObject *context,
+                                 std::function<Result(const TaskContext &)> work,
+                                 std::function<void(const Result &)> done)
+{
+    QPointer<QObject> guard(context);
+    return submit(priority, ioPath, [this, guard, work, done](const TaskContext &ctx) {
+        Result result = work(ctx);
+        if (ctx.isCancelled()) return;
+
+        // The scheduler lives in the GUI thread for the whole run, the guard
+        // is only dereferenced there, where context would get deleted
+        TaskHandle handle = ctx.handle();
+        QMetaObject::invokeMethod(this, [guard, done, result, handle]() {
+            if (guard && !handle.isCancelled()) done(result);
+        }, Qt::QueuedConnection);
+    });
+}
+
+#endif // TASKSCHEDULER_H
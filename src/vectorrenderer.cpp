@@ -0,0 +1,172 @@
+#include "vectorrenderer.h"
+#include "ziparchive.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QPainter>
+#include <QSvgRenderer>
+
+namespace {
+    // Cache cost is in KB. A handful of viewport sized rasters.
+    constexpr int RASTER_CACHE_KB = 96 * 1024;
+    // Don't rasterize regions bigger than this in one go
+    constexpr int MAX_RASTER_SIDE = 8192;
+
+    QImage renderArea(const QByteArray &data, const QSize &targetSize, const QRect &area)
+    {
+        QSvgRenderer renderer(data);
+        QImage image(area.size(), QImage::Format_ARGB32_Premultiplied);
+        image.fill(Qt::transparent);
+        if (!renderer.isValid()) return image;
+
+        QPainter p(&image);
+        p.setRenderHint(QPainter::Antialiasing);
+        p.translate(-area.topLeft());
+        renderer.render(&p, QRectF(QPointF(0, 0), QSizeF(targetSize)));
+        p.end();
+        return image;
+    }
+}
+
+VectorRenderer::VectorRenderer(QObject *parent)
+    : QObject(parent)
+    , m_cache(RASTER_CACHE_KB)
+    , m_busy(false)
+    , m_hasQueued(false)
+    , m_generation(0)
+    , m_jobGeneration(0)
+{
+}
+
+VectorRenderer::~VectorRenderer()
+{
+    // Worker only touches its own copies, no need to wait for it
+    m_task.cancel();
+}
+
+bool VectorRenderer::isVectorFile(const QString &path)
+{
+    const QString suffix = QFileInfo(path).suffix().toLower();
+    return suffix == "svg" || suffix == "svgz";
+}
+
+bool VectorRenderer::load(const QString &path)
+{
+    clear();
+
+    QByteArray data;
+    if (ZipArchive::isVirtualPath(path)) {
+        bool ok = false;
+        data = ZipArchive::readMember(path, -1, &ok);
+        if (!ok) return false;
+    } else {
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly)) return false;
+        data = file.readAll();
+    }
+
+    QSvgRenderer renderer(data);
+    if (!renderer.isValid()) return false;
+
+    m_data = data;
+    m_defaultSize = renderer.defaultSize();
+    if (m_defaultSize.isEmpty()) {
+        m_defaultSize = renderer.viewBox().size();
+    }
+    return true;
+}
+
+void VectorRenderer::clear()
+{
+    m_data.clear();
+    m_defaultSize = QSize();
+    m_cache.clear();
+    m_cacheCharge.set(0);
+    m_hasQueued = false;
+    m_generation++; // Drop whatever is still being rendered
+    m_task.cancel();
+    m_busy = false;
+}
+
+bool VectorRenderer::isValid() const
+{
+    return !m_data.isEmpty() && !m_defaultSize.isEmpty();
+}
+
+QSize VectorRenderer::defaultSize() const
+{
+    return m_defaultSize;
+}
+
+QImage VectorRenderer::renderDefault() const
+{
+    if (!isValid()) return QImage();
+    return renderArea(m_data, m_defaultSize, QRect(QPoint(0, 0), m_defaultSize));
+}
+
+quint64 VectorRenderer::cacheKey(const QSize &targetSize)
+{
+    return (quint64(quint32(targetSize.width())) << 32) | quint32(targetSize.height());
+}
+
+const VectorRenderer::Raster *VectorRenderer::raster(const QSize &targetSize) const
+{
+    return m_cache.object(cacheKey(targetSize));
+}
+
+void VectorRenderer::request(const QSize &targetSize, const QRect &area)
+{
+    if (!isValid() || targetSize.isEmpty()) return;
+
+    QRect clipped = area & QRect(QPoint(0, 0), targetSize);
+    if (clipped.isEmpty()) return;
+    if (clipped.width() > MAX_RASTER_SIDE) clipped.setWidth(MAX_RASTER_SIDE);
+    if (clipped.height() > MAX_RASTER_SIDE) clipped.setHeight(MAX_RASTER_SIDE);
+
+    // Already have it, or it is on its way
+    const Raster *cached = raster(targetSize);
+    if (cached && cached->area.contains(clipped)) return;
+    if (m_busy && m_pendingSize == targetSize && m_pendingArea.contains(clipped)) return;
+
+    if (m_busy) {
+        // Latest request wins, intermediate zoom levels are not worth rendering
+        m_hasQueued = true;
+        m_queuedSize = targetSize;
+        m_queuedArea = clipped;
+        return;
+    }
+    startRender(targetSize, clipped);
+}
+
+void VectorRenderer::startRender(const QSize &targetSize, const QRect &area)
+{
+    m_busy = true;
+    m_pendingSize = targetSize;
+    m_pendingArea = area;
+    m_jobGeneration = m_generation;
+
+    // What is on screen, so it runs ahead of prefetch and indexing work
+    QByteArray data = m_data;
+    m_task = TaskScheduler::instance()->submit<QImage>(TaskScheduler::Visible, QString(), this,
+        [data, targetSize, area](const TaskContext &) { return renderArea(data, targetSize, area); },
+        [this](const QImage &image) { onRenderFinished(image); });
+}
+
+void VectorRenderer::onRenderFinished(const QImage &image)
+{
+    m_busy = false;
+
+    if (m_jobGeneration == m_generation) {
+        if (!image.isNull()) {
+            Raster *entry = new Raster{m_pendingArea, image};
+            int cost = qMax(1, int(image.sizeInBytes() / 1024));
+            m_cache.insert(cacheKey(m_pendingSize), entry, cost);
+            m_cacheCharge.set(qint64(m_cache.totalCost()) * 1024);
+            emit rendered();
+        }
+    }
+
+    if (m_hasQueued) {
+        m_hasQueued = false;
+        request(m_queuedSize, m_queuedArea);
+    }
+}
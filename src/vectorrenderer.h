@@ -0,0 +1,69 @@
+#ifndef VECTORRENDERER_H
+#define VECTORRENDERER_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QCache>
+#include <QImage>
+#include <QRect>
+#include <QSize>
+#include "memorybudget.h"
+#include "taskscheduler.h"
+
+// Renders SVG sources at the size they are actually displayed at.
+// Rasterization happens on a TaskScheduler worker and only covers the requested
+// area (the visible part of the canvas plus some margin). Finished rasters
+// are kept in a small cache keyed by zoom level (the target canvas size),
+// so zooming back and forth does not re-render.
+class VectorRenderer : public QObject
+{
+    Q_OBJECT
+public:
+    struct Raster {
+        QRect area;   // In canvas coordinates
+        QImage image;
+    };
+
+    explicit VectorRenderer(QObject *parent = nullptr);
+    ~VectorRenderer();
+
+    static bool isVectorFile(const QString &path);
+
+    bool load(const QString &path);
+    void clear();
+    bool isValid() const;
+
+    QSize defaultSize() const;
+    QImage renderDefault() const; // Intrinsic size, used as a stand-in while zooming
+
+    // Cached raster for this zoom level, or nullptr. May not cover the whole area asked for.
+    const Raster *raster(const QSize &targetSize) const;
+    void request(const QSize &targetSize, const QRect &area);
+
+signals:
+    void rendered();
+
+private:
+    void onRenderFinished(const QImage &image);
+
+    static quint64 cacheKey(const QSize &targetSize);
+    void startRender(const QSize &targetSize, const QRect &area);
+
+    QByteArray m_data;
+    QSize m_defaultSize;
+    QCache<quint64, Raster> m_cache;
+    MemoryCharge m_cacheCharge;
+    TaskHandle m_task;
+
+    // One job in flight, plus the most recent request that arrived meanwhile
+    bool m_busy;
+    QSize m_pendingSize;
+    QRect m_pendingArea;
+    bool m_hasQueued;
+    QSize m_queuedSize;
+    QRect m_queuedArea;
+    quint64 m_generation;
+    quint64 m_jobGeneration;
+};
+
+#endif // VECTORRENDERER_H
@@ -0,0 +1,376 @@
+#include "ziparchive.h"
+#include "imagedecoder.h"
+#include <QCache>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutex>
+#include <algorithm>
+#include <limits>
+#include <zlib.h>
+
+namespace {
+    constexpr quint32 LOCAL_HEADER_SIG = 0x04034b50;
+    constexpr quint32 CENTRAL_HEADER_SIG = 0x02014b50;
+    constexpr quint32 END_RECORD_SIG = 0x06054b50;
+    constexpr quint32 ZIP64_END_RECORD_SIG = 0x06064b50;
+    constexpr quint32 ZIP64_LOCATOR_SIG = 0x07064b50;
+
+    constexpr int LOCAL_HEADER_SIZE = 30;
+    constexpr int CENTRAL_HEADER_SIZE = 46;
+    constexpr int END_RECORD_SIZE = 22;
+    constexpr int ZIP64_LOCATOR_SIZE = 20;
+    constexpr int ZIP64_END_RECORD_SIZE = 56;
+    constexpr int MAX_COMMENT_SIZE = 0xffff;
+
+    constexpr quint16 FLAG_ENCRYPTED = 0x0001;
+    constexpr quint16 FLAG_UTF8_NAME = 0x0800;
+    constexpr quint16 METHOD_STORED = 0;
+    constexpr quint16 METHOD_DEFLATE = 8;
+
+    // Parsed directories kept around; flipping between a few archives never re-parses
+    constexpr int INDEX_CACHE_ARCHIVES = 8;
+    constexpr qint64 INFLATE_INPUT_CHUNK = 64 * 1024;
+
+    quint16 le16(const uchar *p)
+    {
+        return quint16(p[0] | (p[1] << 8));
+    }
+
+    quint32 le32(const uchar *p)
+    {
+        return quint32(p[0] | (p[1] << 8) | (p[2] << 16) | (quint32(p[3]) << 24));
+    }
+
+    quint64 le64(const uchar *p)
+    {
+        return quint64(le32(p)) | (quint64(le32(p + 4)) << 32);
+    }
+
+    QDateTime fromDosTime(quint16 time, quint16 date)
+    {
+        return QDateTime(QDate(1980 + (date >> 9), (date >> 5) & 0x0f, date & 0x1f),
+                         QTime(time >> 11, (time >> 5) & 0x3f, (time & 0x1f) * 2));
+    }
+
+    struct IndexCache {
+        QMutex mutex;
+        QCache<QString, QSharedPointer<const ZipArchive>> archives{INDEX_CACHE_ARCHIVES};
+    };
+
+    IndexCache &indexCache()
+    {
+        static IndexCache cache;
+        return cache;
+    }
+}
+
+ZipArchive::ZipArchive()
+    : m_fileSize(0)
+{
+}
+
+bool ZipArchive::isArchiveFile(const QString &path)
+{
+    return path.endsWith(".zip", Qt::CaseInsensitive) || path.endsWith(".cbz", Qt::CaseInsensitive);
+}
+
+bool ZipArchive::splitVirtualPath(const QString &path, QString *archivePath, QString *member)
+{
+    // Cheap reject first, this runs for every path the decoder sees
+    if (!path.contains(".zip/", Qt::CaseInsensitive) && !path.contains(".cbz/", Qt::CaseInsensitive)) {
+        return false;
+    }
+
+    // Leftmost component that is an archive file on disk; "a.zip" folders are just folders
+    for (int slash = path.indexOf('/', 1); slash > 0; slash = path.indexOf('/', slash + 1)) {
+        const QString candidate = path.left(slash);
+        if (isArchiveFile(candidate) && QFileInfo(candidate).isFile()) {
+            const QString name = path.mid(slash + 1);
+            if (name.isEmpty()) return false;
+            if (archivePath) *archivePath = candidate;
+            if (member) *member = name;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ZipArchive::isVirtualPath(const QString &path)
+{
+    return splitVirtualPath(path, nullptr, nullptr);
+}
+
+QString ZipArchive::physicalPath(const QString &path)
+{
+    QString archivePath;
+    return splitVirtualPath(path, &archivePath, nullptr) ? archivePath : path;
+}
+
+QSharedPointer<const ZipArchive> ZipArchive::open(const QString &archivePath)
+{
+    QFileInfo info(archivePath);
+    if (!info.isFile()) return QSharedPointer<const ZipArchive>();
+    const QString key = info.absoluteFilePath();
+
+    IndexCache &cache = indexCache();
+    {
+        QMutexLocker lock(&cache.mutex);
+        if (QSharedPointer<const ZipArchive> *cached = cache.archives.object(key)) {
+            // Rewritten archives are parsed again
+            if ((*cached)->m_fileSize == info.size() && (*cached)->m_modified == info.lastModified()) {
+                return *cached;
+            }
+            cache.archives.remove(key);
+        }
+    }
+
+    // Parsed without the lock held; two threads racing on the same archive both just parse it
+    QSharedPointer<ZipArchive> archive(new ZipArchive);
+    archive->m_path = key;
+    archive->m_fileSize = info.size();
+    archive->m_modified = info.lastModified();
+    if (!archive->parse()) return QSharedPointer<const ZipArchive>();
+
+    QMutexLocker lock(&cache.mutex);
+    cache.archives.insert(key, new QSharedPointer<const ZipArchive>(archive));
+    return archive;
+}
+
+QStringList ZipArchive::imagePaths(const QString &archivePath)
+{
+    QStringList paths;
+    QSharedPointer<const ZipArchive> archive = open(archivePath);
+    if (!archive) return paths;
+
+    QStringList suffixes;
+    for (const QString &filter : ImageDecoder::nameFilters()) {
+        suffixes << filter.mid(1); // "*.jpg" -> ".jpg"
+    }
+
+    paths.reserve(archive->m_members.size());
+    for (const Member &member : archive->m_members) {
+        for (const QString &suffix : std::as_const(suffixes)) {
+            if (member.name.endsWith(suffix, Qt::CaseInsensitive)) {
+                paths << archive->m_path + "/" + member.name;
+                break;
+            }
+        }
+    }
+    std::sort(paths.begin(), paths.end());
+    return paths;
+}
+
+QByteArray ZipArchive::readMember(const QString &virtualPath, qint64 maxBytes, bool *ok)
+{
+    if (ok) *ok = false;
+    QString archivePath;
+    QString name;
+    if (!splitVirtualPath(virtualPath, &archivePath, &name)) return QByteArray();
+
+    QSharedPointer<const ZipArchive> archive = open(archivePath);
+    const Member *member = archive ? archive->member(name) : nullptr;
+    if (!member) return QByteArray();
+    return archive->read(*member, maxBytes, ok);
+}
+
+bool ZipArchive::memberInfo(const QString &virtualPath, Member *member)
+{
+    QString archivePath;
+    QString name;
+    if (!splitVirtualPath(virtualPath, &archivePath, &name)) return false;
+
+    QSharedPointer<const ZipArchive> archive = open(archivePath);
+    const Member *found = archive ? archive->member(name) : nullptr;
+    if (!found) return false;
+    *member = *found;
+    return true;
+}
+
+QString ZipArchive::path() const
+{
+    return m_path;
+}
+
+QList<ZipArchive::Member> ZipArchive::members() const
+{
+    return m_members;
+}
+
+const ZipArchive::Member *ZipArchive::member(const QString &name) const
+{
+    auto it = m_byName.constFind(name);
+    return it == m_byName.constEnd() ? nullptr : &m_members.at(it.value());
+}
+
+bool ZipArchive::parse()
+{
+    QFile file(m_path);
+    if (!file.open(QIODevice::ReadOnly)) return false;
+    const qint64 fileSize = file.size();
+    if (fileSize < END_RECORD_SIZE) return false;
+
+    // End record: last 22 bytes, unless the archive has a comment
+    const qint64 tailSize = qMin<qint64>(fileSize, END_RECORD_SIZE + MAX_COMMENT_SIZE);
+    const qint64 tailStart = fileSize - tailSize;
+    file.seek(tailStart);
+    const QByteArray tail = file.read(tailSize);
+    const uchar *t = reinterpret_cast<const uchar *>(tail.constData());
+    int end = -1;
+    for (int i = tail.size() - END_RECORD_SIZE; i >= 0; --i) {
+        if (le32(t + i) == END_RECORD_SIG) {
+            end = i;
+            break;
+        }
+    }
+    if (end < 0) return false;
+
+    quint64 entryCount = le16(t + end + 10);
+    quint64 directorySize = le32(t + end + 12);
+    quint64 directoryOffset = le32(t + end + 16);
+
+    if (entryCount == 0xffff || directorySize == 0xffffffff || directoryOffset == 0xffffffff) {
+        // ZIP64: the locator right before the end record points at the real numbers
+        const qint64 locatorPos = tailStart + end - ZIP64_LOCATOR_SIZE;
+        if (locatorPos < 0 || !file.seek(locatorPos)) return false;
+        const QByteArray locator = file.read(ZIP64_LOCATOR_SIZE);
+        const uchar *l = reinterpret_cast<const uchar *>(locator.constData());
+        if (locator.size() != ZIP64_LOCATOR_SIZE || le32(l) != ZIP64_LOCATOR_SIG) return false;
+
+        const quint64 recordPos = le64(l + 8);
+        if (recordPos >= quint64(fileSize) || !file.seek(qint64(recordPos))) return false;
+        const QByteArray record = file.read(ZIP64_END_RECORD_SIZE);
+        const uchar *r = reinterpret_cast<const uchar *>(record.constData());
+        if (record.size() != ZIP64_END_RECORD_SIZE || le32(r) != ZIP64_END_RECORD_SIG) return false;
+        entryCount = le64(r + 32);
+        directorySize = le64(r + 40);
+        directoryOffset = le64(r + 48);
+    }
+    if (directoryOffset > quint64(fileSize) || directorySize > quint64(fileSize) - directoryOffset) return false;
+
+    // The whole central directory in one read, ~100 bytes per member
+    file.seek(qint64(directoryOffset));
+    const QByteArray directory = file.read(qint64(directorySize));
+    if (quint64(directory.size()) != directorySize) return false;
+    const uchar *d = reinterpret_cast<const uchar *>(directory.constData());
+    const qint64 length = directory.size();
+
+    m_members.reserve(int(qMin<quint64>(entryCount, directorySize / CENTRAL_HEADER_SIZE)));
+    qint64 pos = 0;
+    for (quint64 i = 0; i < entryCount; ++i) {
+        if (pos + CENTRAL_HEADER_SIZE > length || le32(d + pos) != CENTRAL_HEADER_SIG) return false;
+        const uchar *h = d + pos;
+        const quint16 flags = le16(h + 8);
+        const quint16 method = le16(h + 10);
+        const quint16 nameLength = le16(h + 28);
+        const quint16 extraLength = le16(h + 30);
+        const quint16 commentLength = le16(h + 32);
+        if (pos + CENTRAL_HEADER_SIZE + nameLength + extraLength + commentLength > length) return false;
+
+        Member member;
+        member.method = method;
+        member.crc = le32(h + 16);
+        member.modified = fromDosTime(le16(h + 12), le16(h + 14));
+        quint64 compressedSize = le32(h + 20);
+        quint64 size = le32(h + 24);
+        quint64 offset = le32(h + 42);
+
+        // Bit 11 marks UTF-8 names. Older tools write the DOS code page, Latin-1 is the closest we have.
+        const char *rawName = reinterpret_cast<const char *>(h + CENTRAL_HEADER_SIZE);
+        member.name = (flags & FLAG_UTF8_NAME) ? QString::fromUtf8(rawName, nameLength)
+                                               : QString::fromLatin1(rawName, nameLength);
+        member.name.replace('\\', '/');
+
+        // ZIP64 extra field: 64 bit values for the fields saturated above, in this order
+        const uchar *extra = h + CENTRAL_HEADER_SIZE + nameLength;
+        for (int e = 0; e + 4 <= extraLength;) {
+            const quint16 id = le16(extra + e);
+            const quint16 fieldSize = le16(extra + e + 2);
+            if (e + 4 + fieldSize > extraLength) break;
+            if (id == 0x0001) {
+                const uchar *v = extra + e + 4;
+                int k = 0;
+                if (size == 0xffffffff && k + 8 <= fieldSize) { size = le64(v + k); k += 8; }
+                if (compressedSize == 0xffffffff && k + 8 <= fieldSize) { compressedSize = le64(v + k); k += 8; }
+                if (offset == 0xffffffff && k + 8 <= fieldSize) { offset = le64(v + k); k += 8; }
+            }
+            e += 4 + fieldSize;
+        }
+        pos += CENTRAL_HEADER_SIZE + nameLength + extraLength + commentLength;
+
+        // Not listed: folders, encrypted or exotically compressed entries, macOS
+        // resource forks ("__MACOSX/._img.jpg") and names escaping the archive
+        if (member.name.isEmpty() || member.name.endsWith('/') || (flags & FLAG_ENCRYPTED)
+            || (method != METHOD_STORED && method != METHOD_DEFLATE)
+            || member.name.startsWith("__MACOSX/") || member.name.startsWith('/')
+            || member.name.contains("../") || offset >= quint64(fileSize)) {
+            continue;
+        }
+        member.compressedSize = qint64(compressedSize);
+        member.size = qint64(size);
+        member.localHeaderOffset = qint64(offset);
+
+        m_byName.insert(member.name, m_members.size());
+        m_members.append(member);
+    }
+    return true;
+}
+
+QByteArray ZipArchive::read(const Member &member, qint64 maxBytes, bool *ok) const
+{
+    if (ok) *ok = false;
+
+    const qint64 wanted = maxBytes >= 0 ? qMin(maxBytes, member.size) : member.size;
+    if (wanted > std::numeric_limits<int>::max()) return QByteArray(); // Not an image we could decode anyway
+
+    // Own handle per read, so any number of workers can read one archive at once
+    QFile file(m_path);
+    if (!file.open(QIODevice::ReadOnly) || !file.seek(member.localHeaderOffset)) return QByteArray();
+
+    // Local name and extra field lengths can differ from the central directory's
+    const QByteArray header = file.read(LOCAL_HEADER_SIZE);
+    const uchar *h = reinterpret_cast<const uchar *>(header.constData());
+    if (header.size() != LOCAL_HEADER_SIZE || le32(h) != LOCAL_HEADER_SIG) return QByteArray();
+    if (!file.seek(member.localHeaderOffset + LOCAL_HEADER_SIZE + le16(h + 26) + le16(h + 28))) return QByteArray();
+
+    QByteArray data;
+    if (member.method == METHOD_STORED) {
+        data = file.read(wanted);
+        if (data.size() != wanted) return QByteArray();
+    } else {
+        // Raw deflate stream, no zlib header
+        z_stream stream = {};
+        if (inflateInit2(&stream, -MAX_WBITS) != Z_OK) return QByteArray();
+
+        data.resize(int(wanted));
+        stream.next_out = reinterpret_cast<Bytef *>(data.data());
+        stream.avail_out = uInt(wanted);
+
+        QByteArray input;
+        qint64 remainingInput = member.compressedSize;
+        int status = Z_OK;
+        while (stream.avail_out > 0 && status != Z_STREAM_END) {
+            if (stream.avail_in == 0) {
+                if (remainingInput <= 0) break;
+                input = file.read(qMin(INFLATE_INPUT_CHUNK, remainingInput));
+                if (input.isEmpty()) break;
+                remainingInput -= input.size();
+                stream.next_in = reinterpret_cast<Bytef *>(input.data());
+                stream.avail_in = uInt(input.size());
+            }
+            status = inflate(&stream, Z_NO_FLUSH);
+            if (status != Z_OK && status != Z_STREAM_END) break;
+        }
+        const bool complete = stream.avail_out == 0;
+        inflateEnd(&stream);
+        if (!complete) return QByteArray();
+    }
+
+    // Partial reads can't be checked, full ones must match
+    if (maxBytes < 0 || wanted == member.size) {
+        const uLong crc = crc32(crc32(0L, Z_NULL, 0), reinterpret_cast<const Bytef *>(data.constData()), uInt(data.size()));
+        if (crc != member.crc) return QByteArray();
+    }
+
+    if (ok) *ok = true;
+    return data;
+}
@@ -0,0 +1,70 @@
+#ifndef ZIPARCHIVE_H
+#define ZIPARCHIVE_H
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QHash>
+#include <QSharedPointer>
+#include <QString>
+#include <QStringList>
+
+// Read-only view of a ZIP / CBZ archive as a virtual folder.
+//
+// Members are addressed with ordinary looking paths that continue past the
+// archive file: "/photos/shoot.zip/raw/0001.jpg". Everything that takes a
+// file path (decoder, metadata index, vector renderer) goes through
+// readMember() for such paths instead of opening them.
+//
+// The central directory is parsed once per archive (and again only when the
+// archive changes on disk); members are inflated on demand straight from
+// their offset, so opening member 5000 costs one seek and one inflate.
+// Thread safe: lookups go through a mutex protected index cache and every
+// read opens its own file handle.
+class ZipArchive
+{
+public:
+    struct Member {
+        QString name;              // Path inside the archive
+        quint16 method = 0;        // 0 stored, 8 deflate
+        quint32 crc = 0;
+        qint64 compressedSize = 0;
+        qint64 size = 0;
+        qint64 localHeaderOffset = 0;
+        QDateTime modified;
+    };
+
+    static bool isArchiveFile(const QString &path); // By suffix: .zip, .cbz
+    // Splits a virtual path into the archive file and the member name. False for normal paths.
+    static bool splitVirtualPath(const QString &path, QString *archivePath, QString *member);
+    static bool isVirtualPath(const QString &path);
+    // The file on disk that holds path: the archive for members, path itself otherwise
+    static QString physicalPath(const QString &path);
+
+    // Parsed (and cached) central directory, null if the archive can't be read
+    static QSharedPointer<const ZipArchive> open(const QString &archivePath);
+
+    // Virtual paths of the members the decoder can open, in name order
+    static QStringList imagePaths(const QString &archivePath);
+
+    // Inflates a member. maxBytes >= 0 stops early (headers, EXIF); only
+    // complete reads are checked against the stored CRC.
+    static QByteArray readMember(const QString &virtualPath, qint64 maxBytes = -1, bool *ok = nullptr);
+    static bool memberInfo(const QString &virtualPath, Member *member);
+
+    QString path() const;
+    QList<Member> members() const;
+    const Member *member(const QString &name) const;
+    QByteArray read(const Member &member, qint64 maxBytes = -1, bool *ok = nullptr) const;
+
+private:
+    ZipArchive();
+    bool parse();
+
+    QString m_path;
+    qint64 m_fileSize;
+    QDateTime m_modified;
+    QList<Member> m_members;
+    QHash<QString, int> m_byName;
+};
+
+#endif // ZIPARCHIVE_H
@@ -0,0 +1,22 @@
+#include "zoommath.h"
+#include <QWheelEvent>
+#include <QtGlobal>
+#include <cmath>
+
+double ZoomMath::maxZoom(double actualSizeFactor)
+{
+    return qMax(MAX_ZOOM, actualSizeFactor * MAX_ZOOM);
+}
+
+bool ZoomMath::isTouchpad(const QWheelEvent *event)
+{
+    return !event->pixelDelta().isNull();
+}
+
+double ZoomMath::wheelFactor(const QWheelEvent *event)
+{
+    if (isTouchpad(event)) {
+        return std::pow(2.0, event->pixelDelta().y() / TOUCHPAD_PIXELS_PER_DOUBLING);
+    }
+    return std::pow(WHEEL_ZOOM_FACTOR, event->angleDelta().y() / 120.0);
+}
@@ -0,0 +1,28 @@
+#ifndef ZOOMMATH_H
+#define ZOOMMATH_H
+
+class QWheelEvent;
+
+// Zoom limits and wheel response shared by the image tab and compare mode,
+// so the same wheel notch or touchpad swipe zooms both views alike.
+class ZoomMath
+{
+public:
+    static constexpr double MIN_ZOOM = 0.1;
+    static constexpr double MAX_ZOOM = 5.0;
+    // One wheel notch (120 units) multiplies zoom by this, fractions for hi-res wheels
+    static constexpr double WHEEL_ZOOM_FACTOR = 1.2;
+    // Touchpad scroll distance (in pixels) that doubles the zoom
+    static constexpr double TOUCHPAD_PIXELS_PER_DOUBLING = 300.0;
+
+    // actualSizeFactor is the zoom that shows the source at 1:1. Sources larger
+    // than the viewport get the same 5x headroom past 1:1.
+    static double maxZoom(double actualSizeFactor);
+
+    // Touchpads report pixel distances, mouse wheels angles in notches
+    static bool isTouchpad(const QWheelEvent *event);
+    // Zoom multiplier for one event, 1.0 when it does not scroll vertically
+    static double wheelFactor(const QWheelEvent *event);
+};
+
+#endif // ZOOMMATH_H
@@ -0,0 +1,85 @@
+#ifndef TESTUTILS_H
+#define TESTUTILS_H
+
+#include <QColor>
+#include <QDir>
+#include <QImage>
+#include <QPainter>
+#include <QSignalSpy>
+#include <QString>
+#include <QtTest>
+#include <cstdlib>
+#include "imagetab.h"
+
+namespace TestUtils {
+
+// Four flat quadrants. Interior pixels keep their exact color at any zoom,
+// only the seams and borders get filtered.
+inline QImage quadrantImage(const QSize &size,
+                            const QColor &topLeft = Qt::red, const QColor &topRight = Qt::green,
+                            const QColor &bottomLeft = Qt::blue, const QColor &bottomRight = Qt::yellow)
+{
+    QImage image(size, QImage::Format_RGB32);
+    const int w = size.width() / 2;
+    const int h = size.height() / 2;
+    QPainter p(&image);
+    p.fillRect(0, 0, w, h, topLeft);
+    p.fillRect(w, 0, size.width() - w, h, topRight);
+    p.fillRect(0, h, w, size.height() - h, bottomLeft);
+    p.fillRect(w, h, size.width() - w, size.height() - h, bottomRight);
+    p.end();
+    return image;
+}
+
+inline QString writeImage(const QDir &dir, const QString &name, const QImage &image)
+{
+    const QString path = dir.absoluteFilePath(name);
+    // Format from the suffix, except for mixed case names like "b.PNG"
+    const QByteArray format = QFileInfo(name).suffix().toLower().toLatin1();
+    if (!image.save(path, format.constData())) return QString();
+    return path;
+}
+
+inline bool colorsClose(QRgb a, QRgb b, int tolerance)
+{
+    return qAbs(qRed(a) - qRed(b)) <= tolerance
+        && qAbs(qGreen(a) - qGreen(b)) <= tolerance
+        && qAbs(qBlue(a) - qBlue(b)) <= tolerance;
+}
+
+// Fraction of pixels further than tolerance from the reference. Sizes must match.
+inline double mismatchFraction(const QImage &actual, const QImage &expected, int tolerance)
+{
+    if (actual.size() != expected.size() || actual.isNull()) return 1.0;
+    const QImage a = actual.convertToFormat(QImage::Format_RGB32);
+    const QImage e = expected.convertToFormat(QImage::Format_RGB32);
+    qint64 bad = 0;
+    for (int y = 0; y < a.height(); ++y) {
+        const QRgb *ra = reinterpret_cast<const QRgb *>(a.constScanLine(y));
+        const QRgb *re = reinterpret_cast<const QRgb *>(e.constScanLine(y));
+        for (int x = 0; x < a.width(); ++x) {
+            if (!colorsClose(ra[x], re[x], tolerance)) bad++;
+        }
+    }
+    return double(bad) / (qint64(a.width()) * a.height());
+}
+
+// Blocks until the tab has put pixels (or an error) on screen
+inline bool waitForImage(ImageTab *tab, int timeoutMs = 5000)
+{
+    QSignalSpy spy(tab, &ImageTab::imageLoaded);
+    if (tab->isImageLoaded()) return true;
+    return spy.wait(timeoutMs) && tab->isImageLoaded();
+}
+
+// Timing budgets are for a reasonably current desktop. MYVIEW_PERF_SCALE=3 on slow CI.
+inline double perfScale()
+{
+    const double scale = qEnvironmentVariableIsSet("MYVIEW_PERF_SCALE")
+        ? std::atof(qgetenv("MYVIEW_PERF_SCALE").constData()) : 1.0;
+    return scale > 0.0 ? scale : 1.0;
+}
+
+}
+
+#endif // TESTUTILS_H
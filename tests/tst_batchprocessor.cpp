@@ -0,0 +1,108 @@
+#include <QtTest>
+#include <QImageReader>
+#include <QSet>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include "batchprocessor.h"
+#include "taskscheduler.h"
+#include "testutils.h"
+
+// Headless conversion run in-process, the way --convert drives it.
+class TestBatchProcessor : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void sameBaseNamesGetDistinctOutputs();
+    void jobsRunConcurrently();
+};
+
+void TestBatchProcessor::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled(true);
+}
+
+void TestBatchProcessor::sameBaseNamesGetDistinctOutputs()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QDir root(dir.path());
+    QVERIFY(root.mkpath("d1") && root.mkpath("d2") && root.mkpath("out"));
+
+    // Same name in two folders, and one name with two extensions. Every input has
+    // its own size, so an output written twice shows up as a missing size.
+    BatchProcessor::Options options;
+    options.mode = BatchProcessor::Convert;
+    options.format = "png";
+    options.outputDir = root.absoluteFilePath("out");
+    options.inputs << TestUtils::writeImage(QDir(root.filePath("d1")), "IMG_0001.png", TestUtils::quadrantImage(QSize(40, 30)))
+                   << TestUtils::writeImage(QDir(root.filePath("d2")), "IMG_0001.png", TestUtils::quadrantImage(QSize(42, 30)))
+                   << TestUtils::writeImage(QDir(root.filePath("d1")), "a.jpg", TestUtils::quadrantImage(QSize(44, 30)))
+                   << TestUtils::writeImage(QDir(root.filePath("d1")), "a.png", TestUtils::quadrantImage(QSize(46, 30)));
+    for (const QString &input : std::as_const(options.inputs)) {
+        QVERIFY(!input.isEmpty());
+    }
+
+    const QStringList outputs = BatchProcessor::outputPaths(options);
+    QCOMPARE(outputs.size(), options.inputs.size());
+    QCOMPARE(QSet<QString>(outputs.begin(), outputs.end()).size(), outputs.size());
+    // The first of each name keeps it
+    QCOMPARE(QFileInfo(outputs.at(0)).fileName(), QString("IMG_0001.png"));
+    QCOMPARE(QFileInfo(outputs.at(2)).fileName(), QString("a.png"));
+
+    BatchProcessor processor(options);
+    QSignalSpy finished(&processor, &BatchProcessor::finished);
+    processor.start();
+    QVERIFY(finished.wait(10000));
+    QCOMPARE(finished.first().first().toInt(), 0);
+
+    QCOMPARE(QDir(options.outputDir).entryList(QDir::Files).size(), options.inputs.size());
+    QCOMPARE(QImageReader(outputs.at(0)).size(), QSize(40, 30));
+    QCOMPARE(QImageReader(outputs.at(1)).size(), QSize(42, 30));
+    QCOMPARE(QImageReader(outputs.at(2)).size(), QSize(44, 30));
+    QCOMPARE(QImageReader(outputs.at(3)).size(), QSize(46, 30));
+}
+
+void TestBatchProcessor::jobsRunConcurrently()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QDir root(dir.path());
+    QVERIFY(root.mkpath("in") && root.mkpath("out"));
+    // Slowest disk there is: conversions must still run side by side, only reads queue
+    TaskScheduler *scheduler = TaskScheduler::instance();
+    scheduler->setIoLimit(root.filePath("in"), 1);
+
+    BatchProcessor::Options options;
+    options.mode = BatchProcessor::Convert;
+    options.format = "png";
+    options.outputDir = root.absoluteFilePath("out");
+    options.jobs = qMin(scheduler->counters().workers, 4);
+    for (int i = 0; i < options.jobs * 4; ++i) {
+        const QString input = TestUtils::writeImage(QDir(root.filePath("in")), QString("%1.png").arg(i),
+                                                    TestUtils::quadrantImage(QSize(1600, 1200)));
+        QVERIFY(!input.isEmpty());
+        options.inputs << input;
+    }
+
+    // Sample how many conversions are in flight while the batch runs
+    int peak = 0;
+    QTimer sampler;
+    sampler.setInterval(0);
+    connect(&sampler, &QTimer::timeout, this, [scheduler, &peak]() {
+        peak = qMax(peak, scheduler->counters().running[TaskScheduler::Visible]);
+    });
+    sampler.start();
+
+    BatchProcessor processor(options);
+    QSignalSpy finished(&processor, &BatchProcessor::finished);
+    processor.start();
+    QVERIFY(finished.wait(60000));
+    sampler.stop();
+    QCOMPARE(finished.first().first().toInt(), 0);
+    QCOMPARE(peak, options.jobs);
+}
+
+QTEST_MAIN(TestBatchProcessor)
+#include "tst_batchprocessor.moc"
@@ -0,0 +1,108 @@
+#include <QtTest>
+#include <QApplication>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QWheelEvent>
+#include <algorithm>
+#include "compareview.h"
+#include "imagecanvas.h"
+#include "testutils.h"
+
+// Locked zoom / pan across panes and single pane stepping.
+class TestCompareView : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void init();
+    void panMovesAllPanes();
+    void stepChangesOnlyActivePane();
+
+private:
+    QList<ComparePane *> panes(const CompareView &view) const;
+
+    QScopedPointer<QTemporaryDir> m_dir;
+    QStringList m_images;
+};
+
+void TestCompareView::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled(true);
+}
+
+void TestCompareView::init()
+{
+    m_dir.reset(new QTemporaryDir);
+    QVERIFY(m_dir->isValid());
+    QDir dir(m_dir->path());
+
+    m_images.clear();
+    for (int i = 0; i < 4; ++i) {
+        m_images << TestUtils::writeImage(dir, QString("burst_%1.png").arg(i), TestUtils::quadrantImage(QSize(800, 600)));
+        QVERIFY(!m_images.last().isEmpty());
+    }
+}
+
+QList<ComparePane *> TestCompareView::panes(const CompareView &view) const
+{
+    QList<ComparePane *> result = view.findChildren<ComparePane *>();
+    std::sort(result.begin(), result.end(), [](ComparePane *a, ComparePane *b) {
+        return a->x() + a->y() * 10000 < b->x() + b->y() * 10000;
+    });
+    return result;
+}
+
+void TestCompareView::panMovesAllPanes()
+{
+    CompareView view(m_images, {0, 1});
+    view.resize(640, 240);
+    view.show();
+    QVERIFY(QTest::qWaitForWindowExposed(&view));
+
+    const QList<ComparePane *> all = panes(view);
+    QCOMPARE(all.size(), 2);
+    QTRY_VERIFY(all.at(0)->hasImage() && all.at(1)->hasImage());
+
+    // Zoom in on the first pane around its center, then drag it
+    QWidget *viewport = all.at(0)->viewport();
+    QPoint center = viewport->rect().center();
+    QWheelEvent wheel(center, viewport->mapToGlobal(center), QPoint(), QPoint(0, 120 * 4),
+                      Qt::NoButton, Qt::NoModifier, Qt::NoScrollPhase, false);
+    QApplication::sendEvent(viewport, &wheel);
+
+    QTest::mousePress(viewport, Qt::LeftButton, Qt::NoModifier, center);
+    QTest::mouseMove(viewport, center + QPoint(-30, -20));
+    QTest::mouseRelease(viewport, Qt::LeftButton, Qt::NoModifier, center + QPoint(-30, -20));
+
+    // Same image sizes and pane sizes: both canvases sit at the same spot, no event loop turn needed
+    ImageCanvas *first = all.at(0)->findChild<ImageCanvas *>();
+    ImageCanvas *second = all.at(1)->findChild<ImageCanvas *>();
+    QVERIFY(first->width() > viewport->width());
+    QVERIFY(first->pos() != QPoint(0, 0));
+    QCOMPARE(second->geometry(), first->geometry());
+}
+
+void TestCompareView::stepChangesOnlyActivePane()
+{
+    CompareView view(m_images, {0, 1});
+    view.resize(640, 240);
+    view.show();
+    QVERIFY(QTest::qWaitForWindowExposed(&view));
+
+    const QList<ComparePane *> all = panes(view);
+    QTRY_VERIFY(all.at(0)->hasImage() && all.at(1)->hasImage());
+
+    QTest::keyClick(&view, Qt::Key_Tab);
+    QTest::keyClick(&view, Qt::Key_Right);
+    QTRY_COMPARE(all.at(1)->path(), m_images.at(2));
+    QCOMPARE(all.at(0)->path(), m_images.at(0));
+
+    // Stepping back below the first image is a no-op
+    QTest::keyClick(&view, Qt::Key_Tab);
+    QTest::keyClick(&view, Qt::Key_Left);
+    QCOMPARE(all.at(0)->path(), m_images.at(0));
+}
+
+QTEST_MAIN(TestCompareView)
+#include "tst_compareview.moc"
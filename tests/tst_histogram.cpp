@@ -0,0 +1,99 @@
+#include <QtTest>
+#include "histogram.h"
+#include "imagepyramid.h"
+#include "testutils.h"
+
+// Histogram kernels against counts that are known by construction
+class TestHistogram : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void countsQuadrants();
+    void stripesMergeToWhole();
+    void transparentPixelsAreSkipped();
+    void previewThenExact();
+};
+
+void TestHistogram::countsQuadrants()
+{
+    // Odd width exercises the scalar tail after the four pixel loop
+    QImage image = TestUtils::quadrantImage(QSize(101, 60), Qt::black, Qt::white, Qt::red, QColor(128, 128, 128));
+    HistogramData data = Histogram::count(image, 0, image.height());
+
+    const quint32 left = 50 * 30;
+    const quint32 right = 51 * 30;
+    QCOMPARE(data.pixels, quint64(101 * 60));
+    QCOMPARE(data.clippedShadows, quint64(left));             // Black
+    QCOMPARE(data.clippedHighlights, quint64(right + left));  // White, red
+    QCOMPARE(data.red[255], right + left);
+    QCOMPARE(data.green[0], left + left);
+    QCOMPARE(data.luma[0], left);
+    QCOMPARE(data.luma[255], right);
+    QCOMPARE(data.luma[(255 * 77 + 128) >> 8], left);
+    QCOMPARE(data.luma[128], right);
+}
+
+void TestHistogram::stripesMergeToWhole()
+{
+    QImage image(257, 199, QImage::Format_RGB32);
+    for (int y = 0; y < image.height(); ++y) {
+        for (int x = 0; x < image.width(); ++x) {
+            image.setPixel(x, y, qRgb(x & 255, y & 255, (x * y) & 255));
+        }
+    }
+
+    HistogramData whole = Histogram::count(image, 0, image.height());
+    HistogramData merged;
+    for (int y = 0; y < image.height(); y += 37) {
+        merged.merge(Histogram::count(image, y, y + 37));
+    }
+    QCOMPARE(merged.pixels, whole.pixels);
+    QCOMPARE(merged.lumaSum, whole.lumaSum);
+    QVERIFY(merged.red == whole.red);
+    QVERIFY(merged.green == whole.green);
+    QVERIFY(merged.blue == whole.blue);
+    QVERIFY(merged.luma == whole.luma);
+
+    // Vector luma matches the scalar definition
+    quint64 expectedSum = 0;
+    for (int y = 0; y < image.height(); ++y) {
+        for (int x = 0; x < image.width(); ++x) {
+            const QRgb p = image.pixel(x, y);
+            expectedSum += (qRed(p) * 77 + qGreen(p) * 150 + qBlue(p) * 29 + 128) >> 8;
+        }
+    }
+    QCOMPARE(whole.lumaSum, expectedSum);
+}
+
+void TestHistogram::transparentPixelsAreSkipped()
+{
+    QImage image(10, 10, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+    image.setPixel(0, 0, qPremultiply(qRgba(255, 0, 0, 255)));
+    image.setPixel(1, 0, qPremultiply(qRgba(0, 0, 255, 128)));
+
+    HistogramData data = Histogram::count(image, 0, image.height());
+    QCOMPARE(data.pixels, quint64(2));
+    QCOMPARE(data.red[255], 1u);
+    QVERIFY(data.blue[255] + data.blue[254] == 1u); // Unpremultiply rounding
+}
+
+void TestHistogram::previewThenExact()
+{
+    ImagePyramid pyramid(TestUtils::quadrantImage(QSize(2048, 1536)));
+    QVERIFY(pyramid.levelCount() > 1);
+
+    Histogram histogram;
+    QSignalSpy spy(&histogram, &Histogram::updated);
+    histogram.setImage(pyramid, TaskScheduler::Visible);
+
+    // Preview is there right away, exact counts follow from the workers
+    QCOMPARE(spy.count(), 1);
+    QVERIFY(histogram.data().approximate);
+    QTRY_VERIFY(!histogram.data().approximate);
+    QCOMPARE(histogram.data().pixels, quint64(2048) * 1536);
+}
+
+QTEST_MAIN(TestHistogram)
+#include "tst_histogram.moc"
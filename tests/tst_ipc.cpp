@@ -0,0 +1,89 @@
+#include <QtTest>
+#include <QDataStream>
+#include <QLocalSocket>
+#include <QStandardPaths>
+#include <QTabWidget>
+#include <QTemporaryDir>
+#include "mainwindow.h"
+#include "testutils.h"
+
+// A second launch hands its arguments to the running window over the local
+// socket. These tests play the second launch.
+class TestIpc : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void openRequestAddsTab();
+    void repeatedRequestFocusesExistingTab();
+
+private:
+    bool sendPaths(const QStringList &paths);
+
+    QTemporaryDir m_dir;
+    QString m_imagePath;
+};
+
+void TestIpc::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled(true);
+    QVERIFY(m_dir.isValid());
+    m_imagePath = TestUtils::writeImage(QDir(m_dir.path()), "sent.png", TestUtils::quadrantImage(QSize(64, 48)));
+    QVERIFY(!m_imagePath.isEmpty());
+}
+
+bool TestIpc::sendPaths(const QStringList &paths)
+{
+    // Same wire format as main(): one QDataStream'd QStringList
+    QLocalSocket socket;
+    socket.connectToServer("myview_server");
+    if (!socket.waitForConnected(1000)) return false;
+
+    QDataStream out(&socket);
+    out << paths;
+    socket.flush();
+    return socket.waitForBytesWritten(1000);
+}
+
+void TestIpc::openRequestAddsTab()
+{
+    MainWindow window;
+    window.show();
+    QVERIFY(QTest::qWaitForWindowExposed(&window));
+
+    QTabWidget *tabs = window.findChild<QTabWidget *>();
+    QVERIFY(tabs);
+    const int before = tabs->count();
+
+    QVERIFY(sendPaths(QStringList() << m_imagePath));
+    QTRY_COMPARE(tabs->count(), before + 1);
+
+    ImageTab *tab = qobject_cast<ImageTab *>(tabs->currentWidget());
+    QVERIFY(tab);
+    QCOMPARE(QFileInfo(tab->currentFilePath()).canonicalFilePath(), QFileInfo(m_imagePath).canonicalFilePath());
+}
+
+void TestIpc::repeatedRequestFocusesExistingTab()
+{
+    MainWindow window;
+    window.show();
+    QVERIFY(QTest::qWaitForWindowExposed(&window));
+
+    QTabWidget *tabs = window.findChild<QTabWidget *>();
+    QVERIFY(tabs);
+
+    QVERIFY(sendPaths(QStringList() << m_imagePath));
+    QTRY_VERIFY(qobject_cast<ImageTab *>(tabs->currentWidget()));
+    const int imageTab = tabs->currentIndex();
+    const int count = tabs->count();
+
+    // Move away, then ask for the same file again: back to its tab, no new one
+    tabs->setCurrentIndex(imageTab == 0 ? 1 : 0);
+    QVERIFY(sendPaths(QStringList() << m_imagePath));
+    QTRY_COMPARE(tabs->currentIndex(), imageTab);
+    QCOMPARE(tabs->count(), count);
+}
+
+QTEST_MAIN(TestIpc)
+#include "tst_ipc.moc"
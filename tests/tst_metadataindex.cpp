@@ -0,0 +1,206 @@
+#include <QtTest>
+#include <QBuffer>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include "metadataindex.h"
+#include "testutils.h"
+
+namespace {
+    void put16(QByteArray *out, quint16 value)
+    {
+        out->append(char(value & 0xFF));
+        out->append(char(value >> 8));
+    }
+
+    void put32(QByteArray *out, quint32 value)
+    {
+        put16(out, quint16(value & 0xFFFF));
+        put16(out, quint16(value >> 16));
+    }
+
+    void putEntry(QByteArray *out, quint16 tag, quint16 type, quint32 count, quint32 value)
+    {
+        put16(out, tag);
+        put16(out, type);
+        put32(out, count);
+        put32(out, value);
+    }
+
+    // Little endian TIFF with orientation 6 and DateTimeOriginal in the Exif IFD
+    QByteArray validTiff()
+    {
+        QByteArray tiff("II");
+        put16(&tiff, 42);
+        put32(&tiff, 8);
+        // IFD0 at 8: two entries, ends at 38
+        put16(&tiff, 2);
+        putEntry(&tiff, 0x0112, 3, 1, 6);
+        putEntry(&tiff, 0x8769, 4, 1, 38);
+        put32(&tiff, 0);
+        // Exif IFD at 38: one entry, its string follows at 56
+        put16(&tiff, 1);
+        putEntry(&tiff, 0x9003, 2, 20, 56);
+        put32(&tiff, 0);
+        tiff.append("2021:06:15 10:30:00", 20);
+        return tiff;
+    }
+
+    // IFD0 pointing at offset, the rest empty
+    QByteArray tiffWithIfd0At(quint32 offset)
+    {
+        QByteArray tiff("II");
+        put16(&tiff, 42);
+        put32(&tiff, offset);
+        put32(&tiff, 0);
+        return tiff;
+    }
+
+    // IFD0 whose Exif IFD pointer is offset
+    QByteArray tiffWithExifAt(quint32 offset)
+    {
+        QByteArray tiff("II");
+        put16(&tiff, 42);
+        put32(&tiff, 8);
+        put16(&tiff, 1);
+        putEntry(&tiff, 0x8769, 4, 1, offset);
+        put32(&tiff, 0);
+        return tiff;
+    }
+
+    // A real JPEG with the TIFF blob spliced in as an APP1 segment right after SOI
+    QByteArray jpegWithExif(const QByteArray &tiff)
+    {
+        QByteArray jpeg;
+        QBuffer buffer(&jpeg);
+        buffer.open(QIODevice::WriteOnly);
+        TestUtils::quadrantImage(QSize(64, 48)).save(&buffer, "jpg");
+
+        QByteArray app1("\xFF\xE1", 2);
+        const int length = 2 + 6 + tiff.size();
+        app1.append(char(length >> 8));
+        app1.append(char(length & 0xFF));
+        app1.append("Exif\0\0", 6);
+        app1.append(tiff);
+        return jpeg.insert(2, app1);
+    }
+}
+
+// Header and EXIF reads, which run on every file of every folder opened.
+class TestMetadataIndex : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void readsExif();
+    void survivesHostileExif_data();
+    void survivesHostileExif();
+    void survivesTruncatedExif();
+    void updatesIncrementally();
+
+private:
+    ImageMetadata readJpeg(const QString &name, const QByteArray &tiff);
+
+    QTemporaryDir m_dir;
+};
+
+void TestMetadataIndex::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled(true);
+    QVERIFY(m_dir.isValid());
+}
+
+ImageMetadata TestMetadataIndex::readJpeg(const QString &name, const QByteArray &tiff)
+{
+    const QString path = QDir(m_dir.path()).absoluteFilePath(name);
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly) || file.write(jpegWithExif(tiff)) < 0) return ImageMetadata();
+    file.close();
+    return MetadataIndex::read(QFileInfo(path));
+}
+
+void TestMetadataIndex::readsExif()
+{
+    const ImageMetadata meta = readJpeg("valid.jpg", validTiff());
+    QCOMPARE(meta.format, QByteArray("jpeg"));
+    QCOMPARE(meta.orientation, 6);
+    // Orientation 6 is rotated by 90 degrees on display
+    QCOMPARE(meta.size, QSize(48, 64));
+    QCOMPARE(meta.captureTime, QDateTime(QDate(2021, 6, 15), QTime(10, 30)));
+}
+
+void TestMetadataIndex::survivesHostileExif_data()
+{
+    QTest::addColumn<QByteArray>("tiff");
+    // Offsets that wrap around when 2 or 12 is added to them
+    QTest::newRow("ifd0 at 0xFFFFFFFE") << tiffWithIfd0At(0xFFFFFFFE);
+    QTest::newRow("ifd0 at 0xFFFFFFFF") << tiffWithIfd0At(0xFFFFFFFF);
+    QTest::newRow("ifd0 at 0xFFFFFFF8") << tiffWithIfd0At(0xFFFFFFF8);
+    QTest::newRow("exif ifd at 0xFFFFFFFE") << tiffWithExifAt(0xFFFFFFFE);
+    QTest::newRow("exif ifd at 0xFFFFFFF5") << tiffWithExifAt(0xFFFFFFF5);
+    QTest::newRow("ifd0 at end") << tiffWithIfd0At(12);
+
+    // Many more entries than the blob holds
+    QByteArray overlong = tiffWithIfd0At(8);
+    overlong[8] = char(0xFF);
+    overlong[9] = char(0xFF);
+    QTest::newRow("entry count past end") << overlong;
+
+    // String value whose offset + count wraps
+    QByteArray ascii("II");
+    put16(&ascii, 42);
+    put32(&ascii, 8);
+    put16(&ascii, 1);
+    putEntry(&ascii, 0x0132, 2, 0x20, 0xFFFFFFF0);
+    put32(&ascii, 0);
+    QTest::newRow("string offset wraps") << ascii;
+}
+
+void TestMetadataIndex::survivesHostileExif()
+{
+    QFETCH(QByteArray, tiff);
+    const ImageMetadata meta = readJpeg("hostile.jpg", tiff);
+    // The EXIF is ignored, the header still reads
+    QCOMPARE(meta.orientation, 1);
+    QCOMPARE(meta.size, QSize(64, 48));
+    QVERIFY(meta.captureTime.isValid());
+}
+
+void TestMetadataIndex::survivesTruncatedExif()
+{
+    const QByteArray tiff = validTiff();
+    for (int length = 0; length < tiff.size(); ++length) {
+        const ImageMetadata meta = readJpeg("truncated.jpg", tiff.left(length));
+        QVERIFY2(meta.orientation >= 1 && meta.orientation <= 8, qPrintable(QString("length %1").arg(length)));
+        QVERIFY(meta.captureTime.isValid());
+    }
+}
+
+void TestMetadataIndex::updatesIncrementally()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QDir folder(dir.path());
+    const QString kept = TestUtils::writeImage(folder, "a.png", TestUtils::quadrantImage(QSize(40, 30)));
+    const QString removed = TestUtils::writeImage(folder, "b.png", TestUtils::quadrantImage(QSize(40, 30)));
+
+    MetadataIndex index;
+    QSignalSpy ready(&index, &MetadataIndex::ready);
+    index.index(folder.absolutePath(), {QFileInfo(kept), QFileInfo(removed)});
+    QVERIFY(ready.wait(5000));
+    QCOMPARE(index.metadata(removed).size, QSize(40, 30));
+
+    // A live folder: one capture arrives, one file is deleted
+    const QString added = TestUtils::writeImage(folder, "c.png", TestUtils::quadrantImage(QSize(80, 60)));
+    QFile::remove(removed);
+    index.update({QFileInfo(added)}, {removed});
+    QVERIFY(ready.wait(5000));
+
+    QVERIFY(index.isReady());
+    QCOMPARE(index.metadata(added).size, QSize(80, 60));
+    QVERIFY(!index.metadata(removed).isValid());
+    QCOMPARE(index.metadata(kept).size, QSize(40, 30));
+}
+
+QTEST_MAIN(TestMetadataIndex)
+#include "tst_metadataindex.moc"
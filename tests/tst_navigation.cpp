@@ -0,0 +1,136 @@
+#include <QtTest>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <algorithm>
+#include "testutils.h"
+
+// Folder scanning, next/previous and sort order, driven through the keyboard
+// the same way a user would.
+class TestNavigation : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void init();
+    void scanFiltersUnsupportedFiles();
+    void nextPreviousStopAtEnds();
+    void sortBySize();
+    void deletingCurrentKeepsNeighbours();
+
+private:
+    QScopedPointer<QTemporaryDir> m_dir;
+    QStringList m_images; // Name order
+};
+
+void TestNavigation::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled(true);
+}
+
+void TestNavigation::init()
+{
+    m_dir.reset(new QTemporaryDir);
+    QVERIFY(m_dir->isValid());
+    QDir dir(m_dir->path());
+
+    // Sizes differ on purpose: name order and size order are not the same
+    m_images << TestUtils::writeImage(dir, "a.png", TestUtils::quadrantImage(QSize(64, 48)));
+    m_images << TestUtils::writeImage(dir, "b.PNG", TestUtils::quadrantImage(QSize(32, 24)));
+    m_images << TestUtils::writeImage(dir, "c.bmp", TestUtils::quadrantImage(QSize(40, 30)));
+    for (const QString &path : std::as_const(m_images)) {
+        QVERIFY(!path.isEmpty());
+    }
+
+    QFile notes(dir.absoluteFilePath("notes.txt"));
+    QVERIFY(notes.open(QIODevice::WriteOnly));
+    notes.write("not an image");
+}
+
+void TestNavigation::scanFiltersUnsupportedFiles()
+{
+    ImageTab tab(m_images.at(1));
+    QCOMPARE(tab.imageList(), m_images);
+    QCOMPARE(tab.currentIndex(), 1);
+}
+
+void TestNavigation::nextPreviousStopAtEnds()
+{
+    ImageTab tab(m_images.at(0));
+    tab.resize(320, 240);
+    tab.show();
+    QVERIFY(QTest::qWaitForWindowExposed(&tab));
+    QVERIFY(TestUtils::waitForImage(&tab));
+
+    // Already first: Left is a no-op
+    QTest::keyClick(&tab, Qt::Key_Left);
+    QCOMPARE(tab.currentIndex(), 0);
+
+    for (int i = 1; i < m_images.size(); ++i) {
+        QTest::keyClick(&tab, Qt::Key_Right);
+        QCOMPARE(tab.currentIndex(), i);
+        QVERIFY(TestUtils::waitForImage(&tab));
+        QCOMPARE(tab.currentFilePath(), m_images.at(i));
+    }
+
+    // Last: Right is a no-op
+    QTest::keyClick(&tab, Qt::Key_Right);
+    QCOMPARE(tab.currentIndex(), m_images.size() - 1);
+
+    QTest::keyClick(&tab, Qt::Key_Left);
+    QCOMPARE(tab.currentIndex(), m_images.size() - 2);
+    QVERIFY(TestUtils::waitForImage(&tab));
+    QCOMPARE(tab.currentFilePath(), m_images.at(m_images.size() - 2));
+}
+
+void TestNavigation::sortBySize()
+{
+    ImageTab tab(m_images.at(0));
+
+    QStringList bySize = m_images;
+    std::stable_sort(bySize.begin(), bySize.end(), [](const QString &a, const QString &b) {
+        return QFileInfo(a).size() < QFileInfo(b).size();
+    });
+    QVERIFY(bySize != m_images);
+
+    // S cycles Name -> Date -> Size. Sorting waits for the background header index.
+    QTest::keyClick(&tab, Qt::Key_S);
+    QTest::keyClick(&tab, Qt::Key_S);
+    QTRY_COMPARE(tab.imageList(), bySize);
+
+    // The current image keeps its place in the new order
+    QCOMPARE(tab.currentIndex(), bySize.indexOf(m_images.at(0)));
+}
+
+void TestNavigation::deletingCurrentKeepsNeighbours()
+{
+    ImageTab tab(m_images.at(1));
+    tab.resize(320, 240);
+    tab.show();
+    QVERIFY(QTest::qWaitForWindowExposed(&tab));
+    QVERIFY(TestUtils::waitForImage(&tab));
+    QSignalSpy status(&tab, &ImageTab::statusChanged);
+
+    // Deleted while on screen, as live mode reports it: Previous is still the one before
+    QVERIFY(QFile::remove(m_images.at(1)));
+    tab.onFilesRemoved({m_images.at(1)});
+    QCOMPARE(tab.imageList(), QStringList({m_images.at(0), m_images.at(2)}));
+    QTest::keyClick(&tab, Qt::Key_Left);
+    QVERIFY(TestUtils::waitForImage(&tab));
+    QCOMPARE(tab.currentFilePath(), m_images.at(0));
+    QCOMPARE(tab.currentIndex(), 0);
+
+    // The first one: no position of 0, and Next is its successor
+    QVERIFY(QFile::remove(m_images.at(0)));
+    status.clear();
+    tab.onFilesRemoved({m_images.at(0)});
+    QVERIFY(!status.isEmpty());
+    QVERIFY(status.last().first().toString().startsWith("Index: - / 1"));
+    QTest::keyClick(&tab, Qt::Key_Right);
+    QVERIFY(TestUtils::waitForImage(&tab));
+    QCOMPARE(tab.currentFilePath(), m_images.at(2));
+    QCOMPARE(tab.currentIndex(), 0);
+}
+
+QTEST_MAIN(TestNavigation)
+#include "tst_navigation.moc"
@@ -0,0 +1,156 @@
+#include <QtTest>
+#include <QApplication>
+#include <QElapsedTimer>
+#include <QScrollArea>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QWheelEvent>
+#include <algorithm>
+#include "imagecache.h"
+#include "imagecanvas.h"
+#include "painttrace.h"
+#include "testutils.h"
+
+namespace {
+    // Budgets in milliseconds, multiplied by MYVIEW_PERF_SCALE
+    constexpr double FIRST_PIXELS_BUDGET_MS = 1500.0; // 12 MP PNG, cold cache
+    constexpr double ZOOM_REPAINT_BUDGET_MS = 16.0;   // Median viewport repaint while zooming
+    // Share of the viewport one canvas paint may cover when only an overlay changed
+    constexpr double OVERLAY_REPAINT_MAX_SHARE = 0.1;
+}
+
+// Coarse timing budgets for the paths users feel: time to first pixels and
+// repaint cost per zoom step. They catch regressions of the "suddenly 10x
+// slower" kind, not percent-level drift.
+class TestPerformance : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void timeToFirstPixels();
+    void zoomRepaintCost();
+    void fastPaintLatchesWhileAnimating();
+    void overlayRepaintArea();
+
+private:
+    QTemporaryDir m_dir;
+    QString m_largePath;
+};
+
+void TestPerformance::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled(true);
+    QVERIFY(m_dir.isValid());
+    m_largePath = TestUtils::writeImage(QDir(m_dir.path()), "large.png", TestUtils::quadrantImage(QSize(4000, 3000)));
+    QVERIFY(!m_largePath.isEmpty());
+}
+
+void TestPerformance::timeToFirstPixels()
+{
+    ImageCache::instance()->invalidate(m_largePath);
+
+    QElapsedTimer timer;
+    timer.start();
+    ImageTab tab(m_largePath);
+    tab.resize(1024, 768);
+    tab.show();
+    QVERIFY(TestUtils::waitForImage(&tab, 10000));
+
+    ImageCanvas *canvas = tab.findChild<ImageCanvas *>();
+    QVERIFY(canvas);
+    canvas->repaint();
+    const double elapsed = timer.nsecsElapsed() / 1e6;
+
+    qInfo("First pixels after %.1f ms", elapsed);
+    QVERIFY2(elapsed < FIRST_PIXELS_BUDGET_MS * TestUtils::perfScale(),
+             qPrintable(QString("%1 ms").arg(elapsed, 0, 'f', 1)));
+}
+
+void TestPerformance::zoomRepaintCost()
+{
+    ImageTab tab(m_largePath);
+    tab.resize(1024, 768);
+    tab.show();
+    QVERIFY(QTest::qWaitForWindowExposed(&tab));
+    QVERIFY(TestUtils::waitForImage(&tab, 10000));
+
+    ImageCanvas *canvas = tab.findChild<ImageCanvas *>();
+    QScrollArea *scrollArea = tab.findChild<QScrollArea *>();
+    QVERIFY(canvas && scrollArea);
+
+    // Touchpad style zoom in then back out, 2^(1/10) per step, one repaint each
+    QVector<double> samples;
+    QPointF center = scrollArea->viewport()->rect().center();
+    for (int i = 0; i < 60; ++i) {
+        const int dy = i < 30 ? 30 : -30;
+        QWheelEvent wheel(center, scrollArea->viewport()->mapToGlobal(center), QPoint(0, dy), QPoint(0, 0),
+                          Qt::NoButton, Qt::ControlModifier, Qt::NoScrollPhase, false);
+        QApplication::sendEvent(scrollArea->viewport(), &wheel);
+        canvas->repaint();
+        samples << canvas->lastPaintMs();
+    }
+    QCOMPARE(qRound(tab.zoomFactor() * 1000), 1000);
+
+    std::sort(samples.begin(), samples.end());
+    const double median = samples.at(samples.size() / 2);
+    qInfo("Zoom repaint median %.2f ms, worst %.2f ms", median, samples.last());
+    QVERIFY2(median < ZOOM_REPAINT_BUDGET_MS * TestUtils::perfScale(),
+             qPrintable(QString("%1 ms").arg(median, 0, 'f', 2)));
+}
+
+void TestPerformance::fastPaintLatchesWhileAnimating()
+{
+    ImageCanvas canvas;
+    canvas.setImage(ImagePyramid(TestUtils::quadrantImage(QSize(800, 600))));
+    canvas.resize(800, 600);
+    canvas.show();
+    QVERIFY(QTest::qWaitForWindowExposed(&canvas));
+
+    // No frame fits a zero budget
+    canvas.setAnimating(true, 0.0);
+    canvas.repaint();
+    QVERIFY(canvas.isFastPaint());
+
+    // The cheap unfiltered frames that follow fit easily, but must not flip back
+    canvas.setAnimating(true, 1e6);
+    for (int i = 0; i < 5; ++i) {
+        canvas.repaint();
+        QVERIFY(canvas.isFastPaint());
+    }
+
+    canvas.setAnimating(false);
+    QVERIFY(!canvas.isFastPaint());
+}
+
+void TestPerformance::overlayRepaintArea()
+{
+    ImageTab tab(m_largePath);
+    tab.resize(1024, 768);
+    tab.show();
+    QVERIFY(QTest::qWaitForWindowExposed(&tab));
+    QVERIFY(TestUtils::waitForImage(&tab, 10000));
+    QTest::qWait(50); // Let the first full frame settle
+
+    // Histogram on (preview, then exact stripes arriving) and off again
+    PaintTrace::instance()->reset();
+    QTest::keyClick(&tab, Qt::Key_H);
+    QTest::qWait(200);
+    QTest::keyClick(&tab, Qt::Key_H);
+    QTest::qWait(50);
+
+    const PaintTrace::Counters overlay = PaintTrace::instance()->counters(PaintTrace::Overlay);
+    const PaintTrace::Counters canvas = PaintTrace::instance()->counters(PaintTrace::Canvas);
+    QVERIFY(overlay.paints > 0);
+
+    // The overlay is not opaque, so the image underneath is re-blitted where the
+    // panel is; no single paint may cover the whole view
+    const qint64 viewportPixels = qint64(tab.width()) * tab.height();
+    qInfo("Overlay: %lld paints, %lld px; canvas: %lld paints, %lld px, largest %lld px",
+          overlay.paints, overlay.pixels, canvas.paints, canvas.pixels, canvas.maxPixels);
+    QVERIFY(canvas.paints > 0);
+    QVERIFY(canvas.maxPixels <= qint64(viewportPixels * OVERLAY_REPAINT_MAX_SHARE));
+}
+
+QTEST_MAIN(TestPerformance)
+#include "tst_performance.moc"
@@ -0,0 +1,177 @@
+#include <QtTest>
+#include <QApplication>
+#include <QScrollArea>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QWheelEvent>
+#include "imagecanvas.h"
+#include "testutils.h"
+
+// Renders known images through ImageTab and compares what the canvas paints
+// with references computed from the source, at Fit, 1:1 and past 1:1.
+class TestRendering : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void fitKeepsAspectAndColors();
+    void actualSizeMatchesSource();
+    void zoomedInMatchesScaledReference();
+    void svgRendersAtDisplaySize();
+
+private:
+    ImageCanvas *canvasOf(ImageTab *tab) const;
+    QImage grabCanvas(ImageTab *tab) const;
+    void zoomToActualSize(ImageTab *tab);
+
+    QTemporaryDir m_dir;
+    QImage m_source;
+    QString m_sourcePath;
+};
+
+void TestRendering::initTestCase()
+{
+    // Keep the metadata index cache out of the user's cache directory
+    QStandardPaths::setTestModeEnabled(true);
+    QVERIFY(m_dir.isValid());
+    // Bigger than the viewport, so 1:1 is a real zoom in from Fit
+    m_source = TestUtils::quadrantImage(QSize(1200, 900));
+    m_sourcePath = TestUtils::writeImage(QDir(m_dir.path()), "quadrants.png", m_source);
+    QVERIFY(!m_sourcePath.isEmpty());
+}
+
+ImageCanvas *TestRendering::canvasOf(ImageTab *tab) const
+{
+    return tab->findChild<ImageCanvas *>();
+}
+
+QImage TestRendering::grabCanvas(ImageTab *tab) const
+{
+    ImageCanvas *canvas = canvasOf(tab);
+    return canvas ? canvas->grab().toImage() : QImage();
+}
+
+void TestRendering::zoomToActualSize(ImageTab *tab)
+{
+    // Double click at Fit toggles to 1:1 (animated)
+    QTest::mouseDClick(tab, Qt::LeftButton, Qt::NoModifier, tab->rect().center());
+    QTRY_COMPARE_WITH_TIMEOUT(canvasOf(tab)->size(), m_source.size(), 2000);
+}
+
+void TestRendering::fitKeepsAspectAndColors()
+{
+    ImageTab tab(m_sourcePath);
+    tab.resize(640, 480);
+    tab.show();
+    QVERIFY(QTest::qWaitForWindowExposed(&tab));
+    QVERIFY(TestUtils::waitForImage(&tab));
+
+    ImageCanvas *canvas = canvasOf(&tab);
+    QVERIFY(canvas);
+    QTRY_VERIFY(!canvas->size().isEmpty());
+    QCOMPARE(tab.zoomFactor(), 1.0);
+
+    // Fit is the source scaled into the viewport, aspect ratio preserved
+    QScrollArea *scrollArea = tab.findChild<QScrollArea *>();
+    QVERIFY(scrollArea);
+    QSize expected = m_source.size().scaled(scrollArea->viewport()->size(), Qt::KeepAspectRatio);
+    QVERIFY(qAbs(canvas->width() - expected.width()) <= 1);
+    QVERIFY(qAbs(canvas->height() - expected.height()) <= 1);
+
+    // Quadrant centers keep their exact colors
+    QImage frame = grabCanvas(&tab);
+    const int w = frame.width();
+    const int h = frame.height();
+    QVERIFY(TestUtils::colorsClose(frame.pixel(w / 4, h / 4), QColor(Qt::red).rgb(), 2));
+    QVERIFY(TestUtils::colorsClose(frame.pixel(3 * w / 4, h / 4), QColor(Qt::green).rgb(), 2));
+    QVERIFY(TestUtils::colorsClose(frame.pixel(w / 4, 3 * h / 4), QColor(Qt::blue).rgb(), 2));
+    QVERIFY(TestUtils::colorsClose(frame.pixel(3 * w / 4, 3 * h / 4), QColor(Qt::yellow).rgb(), 2));
+
+    // And everything else only differs along the filtered seams
+    QImage reference = m_source.scaled(frame.size(), Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+    QVERIFY(TestUtils::mismatchFraction(frame, reference, 8) < 0.02);
+}
+
+void TestRendering::actualSizeMatchesSource()
+{
+    ImageTab tab(m_sourcePath);
+    tab.resize(640, 480);
+    tab.show();
+    QVERIFY(QTest::qWaitForWindowExposed(&tab));
+    QVERIFY(TestUtils::waitForImage(&tab));
+
+    zoomToActualSize(&tab);
+
+    // 1:1 samples the pyramid base without scaling, pixel for pixel
+    QImage frame = grabCanvas(&tab);
+    QCOMPARE(frame.size(), m_source.size());
+    QCOMPARE(TestUtils::mismatchFraction(frame, m_source, 0), 0.0);
+}
+
+void TestRendering::zoomedInMatchesScaledReference()
+{
+    ImageTab tab(m_sourcePath);
+    tab.resize(640, 480);
+    tab.show();
+    QVERIFY(QTest::qWaitForWindowExposed(&tab));
+    QVERIFY(TestUtils::waitForImage(&tab));
+
+    zoomToActualSize(&tab);
+    const double actual = tab.zoomFactor();
+
+    // One touchpad "doubling" worth of pixel scrolling zooms 2x right away
+    QScrollArea *scrollArea = tab.findChild<QScrollArea *>();
+    QPointF center = scrollArea->viewport()->rect().center();
+    QWheelEvent wheel(center, scrollArea->viewport()->mapToGlobal(center), QPoint(0, 300), QPoint(0, 0),
+                      Qt::NoButton, Qt::ControlModifier, Qt::NoScrollPhase, false);
+    QApplication::sendEvent(scrollArea->viewport(), &wheel);
+    QCOMPARE(qRound(tab.zoomFactor() / actual * 100), 200);
+
+    ImageCanvas *canvas = canvasOf(&tab);
+    QSize expectedSize = m_source.size() * 2;
+    QVERIFY(qAbs(canvas->width() - expectedSize.width()) <= 1);
+    QVERIFY(qAbs(canvas->height() - expectedSize.height()) <= 1);
+
+    // Only the visible part is compared, which is all the canvas ever paints
+    QRect visible = canvas->visibleRegion().boundingRect();
+    QVERIFY(!visible.isEmpty());
+    QImage frame = canvas->grab(visible).toImage();
+    QImage reference = m_source.scaled(canvas->size(), Qt::IgnoreAspectRatio, Qt::SmoothTransformation)
+                           .copy(visible);
+    QVERIFY(TestUtils::mismatchFraction(frame, reference, 8) < 0.02);
+}
+
+void TestRendering::svgRendersAtDisplaySize()
+{
+    // Two flat halves, 100x50 intrinsic size
+    const QString path = QDir(m_dir.path()).absoluteFilePath("halves.svg");
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write("<svg xmlns='http://www.w3.org/2000/svg' width='100' height='50'>"
+               "<rect x='0' y='0' width='50' height='50' fill='#ff0000'/>"
+               "<rect x='50' y='0' width='50' height='50' fill='#0000ff'/></svg>");
+    file.close();
+
+    ImageTab tab(path);
+    tab.resize(640, 480);
+    tab.show();
+    QVERIFY(QTest::qWaitForWindowExposed(&tab));
+    QVERIFY(TestUtils::waitForImage(&tab));
+
+    ImageCanvas *canvas = canvasOf(&tab);
+    QTRY_VERIFY(canvas->width() > 100);
+
+    // The sharp raster arrives from a worker; once in, the seam is a hard edge
+    auto seamIsSharp = [&]() {
+        QImage frame = grabCanvas(&tab);
+        const int mid = frame.width() / 2;
+        const int y = frame.height() / 2;
+        return TestUtils::colorsClose(frame.pixel(mid - 2, y), qRgb(255, 0, 0), 2)
+            && TestUtils::colorsClose(frame.pixel(mid + 2, y), qRgb(0, 0, 255), 2);
+    };
+    QTRY_VERIFY_WITH_TIMEOUT(seamIsSharp(), 3000);
+}
+
+QTEST_MAIN(TestRendering)
+#include "tst_rendering.moc"
@@ -0,0 +1,150 @@
+#include <QtTest>
+#include <QFile>
+#include <QStandardPaths>
+#include <QTabWidget>
+#include <QTemporaryDir>
+#include "mainwindow.h"
+#include "session.h"
+#include "testutils.h"
+
+// Session file round trip, and restored tabs only doing work once shown
+class TestSession : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanup();
+    void saveAndLoad();
+    void deferredTabLoadsWhenShown();
+    void restoresZoomAndScroll();
+    void windowRestoresLazily();
+
+private:
+    QTemporaryDir m_dir;
+    QStringList m_images;
+};
+
+void TestSession::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled(true);
+    QVERIFY(m_dir.isValid());
+    QDir dir(m_dir.path());
+    for (int i = 0; i < 3; ++i) {
+        m_images << TestUtils::writeImage(dir, QString("img%1.png").arg(i), TestUtils::quadrantImage(QSize(800, 600)));
+        QVERIFY(!m_images.last().isEmpty());
+    }
+}
+
+void TestSession::cleanup()
+{
+    QFile::remove(Session::filePath());
+}
+
+void TestSession::saveAndLoad()
+{
+    Session session;
+    Session::Tab tab;
+    tab.filePath = m_images.at(1);
+    tab.zoom = 2.5;
+    tab.center = QPointF(0.25, 0.75);
+    session.tabs << tab;
+    session.currentTab = 0;
+    session.windowGeometry = "geometry";
+    QVERIFY(session.save());
+
+    Session loaded = Session::load();
+    QCOMPARE(loaded.tabs.size(), 1);
+    QCOMPARE(loaded.tabs.first().filePath, tab.filePath);
+    QCOMPARE(loaded.tabs.first().zoom, tab.zoom);
+    QCOMPARE(loaded.tabs.first().center, tab.center);
+    QCOMPARE(loaded.currentTab, 0);
+    QCOMPARE(loaded.windowGeometry, QByteArray("geometry"));
+
+    // Garbage is an empty session, not a crash
+    QFile file(Session::filePath());
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write("not a session");
+    file.close();
+    QVERIFY(Session::load().isEmpty());
+}
+
+void TestSession::deferredTabLoadsWhenShown()
+{
+    ImageTab tab(m_images.at(1), nullptr, ImageTab::LoadWhenShown);
+    QCOMPARE(tab.currentFilePath(), m_images.at(1));
+    QVERIFY(tab.imageList().isEmpty()); // No folder scan yet
+    QVERIFY(!tab.isImageLoaded());
+
+    tab.resize(400, 300);
+    tab.show();
+    QVERIFY(TestUtils::waitForImage(&tab));
+    QCOMPARE(tab.imageList(), m_images);
+    QCOMPARE(tab.currentIndex(), 1);
+}
+
+void TestSession::restoresZoomAndScroll()
+{
+    Session::Tab state;
+    state.filePath = m_images.at(0);
+    state.zoom = 2.0;
+    state.center = QPointF(0.4, 0.6);
+
+    ImageTab tab(state.filePath, nullptr, ImageTab::LoadWhenShown);
+    tab.restoreViewState(state);
+    // Not shown yet: saving again gives back exactly what was restored
+    QCOMPARE(tab.viewState().zoom, 2.0);
+
+    tab.resize(400, 300);
+    tab.show();
+    QVERIFY(QTest::qWaitForWindowExposed(&tab));
+    QVERIFY(TestUtils::waitForImage(&tab));
+    QTRY_COMPARE(tab.zoomFactor(), 2.0);
+
+    Session::Tab saved = tab.viewState();
+    QCOMPARE(saved.filePath, state.filePath);
+    QVERIFY(qAbs(saved.center.x() - 0.4) < 0.02);
+    QVERIFY(qAbs(saved.center.y() - 0.6) < 0.02);
+}
+
+void TestSession::windowRestoresLazily()
+{
+    Session session;
+    for (const QString &path : std::as_const(m_images)) {
+        Session::Tab tab;
+        tab.filePath = path;
+        session.tabs << tab;
+    }
+    Session::Tab missing;
+    missing.filePath = QDir(m_dir.path()).absoluteFilePath("deleted.png");
+    session.tabs << missing;
+    session.currentTab = 1;
+    QVERIFY(session.save());
+
+    MainWindow window;
+    QVERIFY(window.restoreSession());
+    window.show();
+    QVERIFY(QTest::qWaitForWindowExposed(&window));
+
+    // Missing file dropped, welcome tab replaced, titles there immediately
+    QTabWidget *tabs = window.findChild<QTabWidget *>();
+    QVERIFY(tabs);
+    QCOMPARE(tabs->count(), 3);
+    QCOMPARE(tabs->tabText(2), QString("img2.png"));
+    QCOMPARE(tabs->currentIndex(), 1);
+
+    // Only the active tab did any work
+    ImageTab *active = qobject_cast<ImageTab *>(tabs->widget(1));
+    QVERIFY(TestUtils::waitForImage(active));
+    QVERIFY(qobject_cast<ImageTab *>(tabs->widget(0))->imageList().isEmpty());
+    QVERIFY(qobject_cast<ImageTab *>(tabs->widget(2))->imageList().isEmpty());
+
+    // The others hydrate on demand
+    tabs->setCurrentIndex(2);
+    ImageTab *other = qobject_cast<ImageTab *>(tabs->widget(2));
+    QVERIFY(TestUtils::waitForImage(other));
+    QCOMPARE(other->currentFilePath(), m_images.at(2));
+}
+
+QTEST_MAIN(TestSession)
+#include "tst_session.moc"
@@ -0,0 +1,157 @@
+#include <QtTest>
+#include <QPainter>
+#include <QRandomGenerator>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include "similarityindex.h"
+#include "testutils.h"
+
+namespace {
+    // Random shapes, the same for the same seed. Different seeds give unrelated scenes.
+    QImage scene(quint32 seed, const QSize &size = QSize(400, 300), int brightness = 0, int shift = 0)
+    {
+        QRandomGenerator random(seed);
+        QImage image(size, QImage::Format_RGB32);
+        image.fill(QColor(random.bounded(256), random.bounded(256), random.bounded(256)));
+        QPainter p(&image);
+        p.setRenderHint(QPainter::Antialiasing);
+        p.setPen(Qt::NoPen);
+        p.translate(shift, shift);
+        for (int i = 0; i < 12; ++i) {
+            p.setBrush(QColor(qBound(0, random.bounded(256) + brightness, 255),
+                              qBound(0, random.bounded(256) + brightness, 255),
+                              qBound(0, random.bounded(256) + brightness, 255)));
+            const QRect rect(random.bounded(size.width()) - 40, random.bounded(size.height()) - 40,
+                             random.bounded(40, 200), random.bounded(40, 160));
+            if (i % 2) p.drawEllipse(rect); else p.drawRect(rect);
+        }
+        p.end();
+        return image;
+    }
+
+    QImage blurred(const QImage &image)
+    {
+        return image.scaled(image.size() / 6, Qt::IgnoreAspectRatio, Qt::SmoothTransformation)
+                    .scaled(image.size(), Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+    }
+}
+
+// Hash stability, burst grouping in navigation order and picking the sharpest shot.
+class TestSimilarityIndex : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void nearDuplicatesAreSimilar();
+    void differentScenesAreNot();
+    void sharperShotScoresHigher();
+    void groupsConsecutiveBursts();
+    void updateHashesLiveFrames();
+};
+
+void TestSimilarityIndex::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled(true);
+}
+
+void TestSimilarityIndex::nearDuplicatesAreSimilar()
+{
+    const ImageHash original = SimilarityIndex::computeFromImage(scene(1));
+    // Next frame of a burst: slightly brighter, moved by a few pixels, different resolution
+    const ImageHash nextFrame = SimilarityIndex::computeFromImage(scene(1, QSize(400, 300), 8, 3));
+    const ImageHash smaller = SimilarityIndex::computeFromImage(scene(1).scaled(200, 150, Qt::IgnoreAspectRatio, Qt::SmoothTransformation));
+    QVERIFY(original.hashed);
+    QVERIFY(SimilarityIndex::isSimilar(original, nextFrame));
+    QVERIFY(SimilarityIndex::isSimilar(original, smaller));
+}
+
+void TestSimilarityIndex::differentScenesAreNot()
+{
+    const ImageHash a = SimilarityIndex::computeFromImage(scene(1));
+    for (quint32 seed = 2; seed < 10; ++seed) {
+        const ImageHash b = SimilarityIndex::computeFromImage(scene(seed));
+        QVERIFY2(!SimilarityIndex::isSimilar(a, b), qPrintable(QString("seed %1").arg(seed)));
+    }
+}
+
+void TestSimilarityIndex::sharperShotScoresHigher()
+{
+    const ImageHash sharp = SimilarityIndex::computeFromImage(scene(3));
+    const ImageHash soft = SimilarityIndex::computeFromImage(blurred(scene(3)));
+    QVERIFY(SimilarityIndex::isSimilar(sharp, soft));
+    QVERIFY(sharp.sharpness > soft.sharpness);
+}
+
+void TestSimilarityIndex::groupsConsecutiveBursts()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QDir folder(dir.path());
+
+    // Two bursts, with the blurry frame of the second one first
+    QStringList paths;
+    paths << TestUtils::writeImage(folder, "a1.png", scene(4));
+    paths << TestUtils::writeImage(folder, "a2.png", scene(4, QSize(400, 300), 6, 2));
+    paths << TestUtils::writeImage(folder, "b1.png", blurred(scene(5)));
+    paths << TestUtils::writeImage(folder, "b2.png", scene(5));
+    paths << TestUtils::writeImage(folder, "b3.png", scene(5, QSize(400, 300), -6, 2));
+    QFileInfoList files;
+    for (const QString &path : std::as_const(paths)) {
+        QVERIFY(!path.isEmpty());
+        files << QFileInfo(path);
+    }
+
+    // Fresh cache, so the file showing up below is this run's
+    const QString cacheDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/similarity";
+    QDir(cacheDir).removeRecursively();
+
+    SimilarityIndex index;
+    QSignalSpy ready(&index, &SimilarityIndex::ready);
+    index.index(folder.absolutePath(), files);
+    QVERIFY(ready.wait(10000));
+    QCOMPARE(index.hashedCount(), paths.size());
+    QCOMPARE(index.groups(paths), QVector<int>({0, 0, 1, 1, 1}));
+    QVERIFY(index.hash(paths.at(3)).sharpness > index.hash(paths.at(2)).sharpness);
+
+    // Reopening reads the hashes back from the disk cache
+    QTRY_VERIFY_WITH_TIMEOUT(!QDir(cacheDir).entryList(QDir::Files).isEmpty(), 5000);
+    SimilarityIndex reopened;
+    QSignalSpy reopenedReady(&reopened, &SimilarityIndex::ready);
+    QSignalSpy progress(&reopened, &SimilarityIndex::progress);
+    reopened.index(folder.absolutePath(), files);
+    QVERIFY(reopenedReady.wait(10000));
+    QCOMPARE(progress.count(), 0); // Nothing had to be decoded
+    QCOMPARE(reopened.groups(paths), index.groups(paths));
+}
+
+void TestSimilarityIndex::updateHashesLiveFrames()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QDir folder(dir.path());
+    const QString first = TestUtils::writeImage(folder, "c1.png", scene(6));
+    const QString other = TestUtils::writeImage(folder, "d1.png", scene(7));
+    QVERIFY(!first.isEmpty() && !other.isEmpty());
+
+    SimilarityIndex index;
+    QSignalSpy ready(&index, &SimilarityIndex::ready);
+    index.index(folder.absolutePath(), {QFileInfo(first), QFileInfo(other)});
+    QVERIFY(ready.wait(10000));
+
+    // A capture rig adds the next frame of the burst, another file is deleted
+    const QString next = TestUtils::writeImage(folder, "c2.png", scene(6, QSize(400, 300), 5, 2));
+    QVERIFY(!next.isEmpty());
+    QFile::remove(other);
+    index.update({QFileInfo(next)}, {other});
+    QVERIFY(ready.wait(10000));
+
+    QVERIFY(index.isReady());
+    QVERIFY(index.hash(next).isValid());
+    QVERIFY(!index.hash(other).isValid());
+    QCOMPARE(index.fileCount(), 2);
+    QCOMPARE(index.groups({first, next}), QVector<int>({0, 0}));
+}
+
+QTEST_MAIN(TestSimilarityIndex)
+#include "tst_similarityindex.moc"
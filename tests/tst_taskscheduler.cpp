@@ -0,0 +1,119 @@
+#include <QtTest>
+#include <QAtomicInt>
+#include <QDeadlineTimer>
+#include <QSemaphore>
+#include <QTemporaryDir>
+#include <QThread>
+#include "taskscheduler.h"
+
+namespace {
+    constexpr int TIMEOUT_MS = 5000;
+
+    // Background work that runs until the scheduler asks it to yield, or the test is done
+    TaskScheduler::Work yieldingWork(QSemaphore *started, QAtomicInt *yielded, QAtomicInt *stop)
+    {
+        return [started, yielded, stop](const TaskContext &ctx) {
+            started->release();
+            QDeadlineTimer deadline(TIMEOUT_MS);
+            while (!deadline.hasExpired() && !stop->loadRelaxed()) {
+                if (ctx.shouldYield()) {
+                    yielded->fetchAndAddRelaxed(1);
+                    return;
+                }
+                QThread::msleep(1);
+            }
+        };
+    }
+}
+
+// Preemption and I/O slots of the shared worker pool, with real workers.
+class TestTaskScheduler : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void backgroundYieldsDeviceToVisible();
+    void backgroundYieldsWorkersToPrefetch();
+    void releasedSlotsLetDecodesRunInParallel();
+
+private:
+    QTemporaryDir m_dir;
+};
+
+void TestTaskScheduler::initTestCase()
+{
+    QVERIFY(m_dir.isValid());
+    // One read at a time on the test folder's device, like a rotational disk
+    TaskScheduler::instance()->setIoLimit(m_dir.path(), 1);
+}
+
+void TestTaskScheduler::backgroundYieldsDeviceToVisible()
+{
+    TaskScheduler *scheduler = TaskScheduler::instance();
+    QSemaphore started;
+    QAtomicInt yielded;
+    QAtomicInt stop;
+    scheduler->submit(TaskScheduler::Background, m_dir.path(), yieldingWork(&started, &yielded, &stop));
+    QVERIFY(started.tryAcquire(1, TIMEOUT_MS));
+
+    // Workers are free, but the only slot of the device is taken
+    QSemaphore visibleRan;
+    scheduler->submit(TaskScheduler::Visible, m_dir.path(), [&visibleRan](const TaskContext &) {
+        visibleRan.release();
+    });
+
+    const bool ran = visibleRan.tryAcquire(1, TIMEOUT_MS);
+    stop.storeRelaxed(1);
+    QTRY_COMPARE_WITH_TIMEOUT(scheduler->counters().running[TaskScheduler::Background], 0, TIMEOUT_MS);
+    QVERIFY(ran);
+    QCOMPARE(yielded.loadRelaxed(), 1);
+}
+
+void TestTaskScheduler::backgroundYieldsWorkersToPrefetch()
+{
+    TaskScheduler *scheduler = TaskScheduler::instance();
+    // Every worker but the one held back for visible work
+    const int background = scheduler->counters().workers - 1;
+    QSemaphore started;
+    QAtomicInt yielded;
+    QAtomicInt stop;
+    for (int i = 0; i < background; ++i) {
+        scheduler->submit(TaskScheduler::Background, QString(), yieldingWork(&started, &yielded, &stop));
+    }
+    QVERIFY(started.tryAcquire(background, TIMEOUT_MS));
+
+    QSemaphore prefetchRan;
+    scheduler->submit(TaskScheduler::Prefetch, QString(), [&prefetchRan](const TaskContext &) {
+        prefetchRan.release();
+    });
+    const bool ran = prefetchRan.tryAcquire(1, TIMEOUT_MS);
+    // The others keep going until told, the next test needs the workers
+    stop.storeRelaxed(1);
+    QTRY_COMPARE_WITH_TIMEOUT(scheduler->counters().running[TaskScheduler::Background], 0, TIMEOUT_MS);
+    QVERIFY(ran);
+    QVERIFY(yielded.loadRelaxed() >= 1);
+}
+
+void TestTaskScheduler::releasedSlotsLetDecodesRunInParallel()
+{
+    // One slot on the device, yet every worker decodes at once after its read
+    TaskScheduler *scheduler = TaskScheduler::instance();
+    const int workers = scheduler->counters().workers;
+    QSemaphore decoding;
+    QSemaphore gate;
+    for (int i = 0; i < workers; ++i) {
+        scheduler->submit(TaskScheduler::Visible, m_dir.path(), [&decoding, &gate](const TaskContext &ctx) {
+            ctx.releaseIo();
+            decoding.release();
+            gate.tryAcquire(1, TIMEOUT_MS);
+        });
+    }
+    const bool allRunning = decoding.tryAcquire(workers, TIMEOUT_MS);
+    gate.release(workers);
+    QVERIFY(allRunning);
+    QTRY_COMPARE_WITH_TIMEOUT(scheduler->counters().running[TaskScheduler::Visible], 0, TIMEOUT_MS);
+}
+
+QTEST_MAIN(TestTaskScheduler)
+#include "tst_taskscheduler.moc"
@@ -0,0 +1,262 @@
+#include <QtTest>
+#include <QBuffer>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <zlib.h>
+#include "imagedecoder.h"
+#include "ziparchive.h"
+#include "testutils.h"
+
+namespace {
+    // Just enough of a ZIP writer to produce test archives: stored or raw
+    // deflate members, central directory, end record.
+    class ZipWriter
+    {
+    public:
+        void add(const QString &name, const QByteArray &data, bool deflate)
+        {
+            QByteArray payload = data;
+            if (deflate) {
+                z_stream stream = {};
+                deflateInit2(&stream, Z_BEST_SPEED, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY);
+                payload.resize(int(deflateBound(&stream, uLong(data.size()))));
+                stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data.constData()));
+                stream.avail_in = uInt(data.size());
+                stream.next_out = reinterpret_cast<Bytef *>(payload.data());
+                stream.avail_out = uInt(payload.size());
+                deflate(&stream, Z_FINISH);
+                payload.resize(int(stream.total_out));
+                deflateEnd(&stream);
+            }
+
+            Entry entry;
+            entry.name = name.toUtf8();
+            entry.method = deflate ? 8 : 0;
+            entry.crc = crc32(crc32(0L, Z_NULL, 0), reinterpret_cast<const Bytef *>(data.constData()), uInt(data.size()));
+            entry.compressedSize = quint32(payload.size());
+            entry.size = quint32(data.size());
+            entry.offset = quint32(m_data.size());
+
+            put32(m_data, 0x04034b50);
+            put16(m_data, 20);
+            put16(m_data, 0x0800); // UTF-8 names
+            put16(m_data, entry.method);
+            put16(m_data, 0);
+            put16(m_data, 0x5021); // 2020-01-01
+            put32(m_data, entry.crc);
+            put32(m_data, entry.compressedSize);
+            put32(m_data, entry.size);
+            put16(m_data, quint16(entry.name.size()));
+            put16(m_data, 0);
+            m_data += entry.name;
+            m_data += payload;
+            m_entries << entry;
+        }
+
+        QByteArray finish() const
+        {
+            QByteArray out = m_data;
+            const quint32 directoryOffset = quint32(out.size());
+            for (const Entry &entry : m_entries) {
+                put32(out, 0x02014b50);
+                put16(out, 20);
+                put16(out, 20);
+                put16(out, 0x0800);
+                put16(out, entry.method);
+                put16(out, 0);
+                put16(out, 0x5021);
+                put32(out, entry.crc);
+                put32(out, entry.compressedSize);
+                put32(out, entry.size);
+                put16(out, quint16(entry.name.size()));
+                put16(out, 0);
+                put16(out, 0);
+                put16(out, 0);
+                put16(out, 0);
+                put32(out, 0);
+                put32(out, entry.offset);
+                out += entry.name;
+            }
+            const quint32 directorySize = quint32(out.size()) - directoryOffset;
+            put32(out, 0x06054b50);
+            put16(out, 0);
+            put16(out, 0);
+            put16(out, quint16(m_entries.size()));
+            put16(out, quint16(m_entries.size()));
+            put32(out, directorySize);
+            put32(out, directoryOffset);
+            put16(out, 0);
+            return out;
+        }
+
+    private:
+        struct Entry {
+            QByteArray name;
+            quint16 method = 0;
+            quint32 crc = 0;
+            quint32 compressedSize = 0;
+            quint32 size = 0;
+            quint32 offset = 0;
+        };
+
+        static void put16(QByteArray &out, quint16 v)
+        {
+            out.append(char(v & 0xff)).append(char(v >> 8));
+        }
+
+        static void put32(QByteArray &out, quint32 v)
+        {
+            put16(out, quint16(v & 0xffff));
+            put16(out, quint16(v >> 16));
+        }
+
+        QByteArray m_data;
+        QList<Entry> m_entries;
+    };
+
+    QByteArray encode(const QImage &image, const char *format)
+    {
+        QByteArray bytes;
+        QBuffer buffer(&bytes);
+        buffer.open(QIODevice::WriteOnly);
+        image.save(&buffer, format);
+        return bytes;
+    }
+}
+
+// Archive index, member reads and the archive-as-folder paths through the decoder and ImageTab
+class TestZipArchive : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void listsImageMembers();
+    void readsStoredAndDeflated();
+    void partialReadStopsEarly();
+    void corruptedMemberFailsCrc();
+    void decodesMembers();
+    void tabBrowsesArchive();
+
+private:
+    QTemporaryDir m_dir;
+    QString m_archive;
+    QByteArray m_png;
+    QByteArray m_text;
+};
+
+void TestZipArchive::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled(true);
+    QVERIFY(m_dir.isValid());
+
+    m_png = encode(TestUtils::quadrantImage(QSize(64, 48)), "png");
+    m_text = QByteArray(200000, 'x');
+
+    ZipWriter writer;
+    writer.add("chapter2/002.png", m_png, true);
+    writer.add("chapter1/001.png", m_png, false);
+    writer.add("chapter1/", QByteArray(), false);
+    writer.add("notes.txt", m_text, true);
+    writer.add("__MACOSX/chapter1/._001.png", "resource fork", false);
+
+    m_archive = QDir(m_dir.path()).absoluteFilePath("book.cbz");
+    QFile file(m_archive);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write(writer.finish());
+}
+
+void TestZipArchive::listsImageMembers()
+{
+    QCOMPARE(ZipArchive::imagePaths(m_archive),
+             QStringList() << m_archive + "/chapter1/001.png" << m_archive + "/chapter2/002.png");
+
+    QSharedPointer<const ZipArchive> archive = ZipArchive::open(m_archive);
+    QVERIFY(archive);
+    QCOMPARE(archive->members().size(), 3); // Folder and resource fork are skipped
+    QVERIFY(archive->member("notes.txt"));
+    QVERIFY(!archive->member("chapter1/"));
+
+    QString archivePath;
+    QString member;
+    QVERIFY(ZipArchive::splitVirtualPath(m_archive + "/chapter2/002.png", &archivePath, &member));
+    QCOMPARE(archivePath, m_archive);
+    QCOMPARE(member, QString("chapter2/002.png"));
+    QVERIFY(!ZipArchive::isVirtualPath(m_archive));
+    QCOMPARE(ZipArchive::physicalPath(m_archive + "/notes.txt"), m_archive);
+}
+
+void TestZipArchive::readsStoredAndDeflated()
+{
+    bool ok = false;
+    QCOMPARE(ZipArchive::readMember(m_archive + "/chapter1/001.png", -1, &ok), m_png);
+    QVERIFY(ok);
+    QCOMPARE(ZipArchive::readMember(m_archive + "/chapter2/002.png", -1, &ok), m_png);
+    QVERIFY(ok);
+    QCOMPARE(ZipArchive::readMember(m_archive + "/notes.txt", -1, &ok), m_text);
+    QVERIFY(ok);
+
+    ZipArchive::readMember(m_archive + "/missing.png", -1, &ok);
+    QVERIFY(!ok);
+}
+
+void TestZipArchive::partialReadStopsEarly()
+{
+    bool ok = false;
+    QByteArray head = ZipArchive::readMember(m_archive + "/notes.txt", 1000, &ok);
+    QVERIFY(ok);
+    QCOMPARE(head, m_text.left(1000));
+}
+
+void TestZipArchive::corruptedMemberFailsCrc()
+{
+    // Flip a byte in the stored member's data, the CRC check has to catch it
+    const QString copy = QDir(m_dir.path()).absoluteFilePath("broken.zip");
+    QVERIFY(QFile::copy(m_archive, copy));
+    QFile file(copy);
+    QVERIFY(file.open(QIODevice::ReadWrite));
+    QByteArray data = file.readAll();
+    const int pos = data.indexOf(m_png, data.indexOf("chapter1/001.png"));
+    QVERIFY(pos > 0);
+    data[pos + m_png.size() / 2] = char(data[pos + m_png.size() / 2] ^ 0xff);
+    file.seek(0);
+    file.write(data);
+    file.close();
+
+    bool ok = true;
+    ZipArchive::readMember(copy + "/chapter1/001.png", -1, &ok);
+    QVERIFY(!ok);
+    QCOMPARE(ImageDecoder::decode(copy + "/chapter1/001.png").error, DecodedImage::CannotRead);
+}
+
+void TestZipArchive::decodesMembers()
+{
+    DecodedImage image = ImageDecoder::decode(m_archive + "/chapter2/002.png");
+    QVERIFY(image.isValid());
+    QCOMPARE(image.pyramid.size(), QSize(64, 48));
+
+    DecodedImage::Error error = DecodedImage::NoError;
+    QImage thumbnail = ImageDecoder::decodeToFit(m_archive + "/chapter1/001.png", QSize(32, 32), &error);
+    QCOMPARE(error, DecodedImage::NoError);
+    QCOMPARE(thumbnail.size(), QSize(32, 24));
+}
+
+void TestZipArchive::tabBrowsesArchive()
+{
+    // Opening the archive itself starts at its first image
+    ImageTab tab(m_archive);
+    const QStringList expected = ZipArchive::imagePaths(m_archive);
+    QCOMPARE(tab.imageList(), expected);
+    QCOMPARE(tab.currentIndex(), 0);
+    QCOMPARE(tab.currentFilePath(), expected.first());
+
+    tab.resize(320, 240);
+    tab.show();
+    QVERIFY(TestUtils::waitForImage(&tab));
+    QTest::keyClick(&tab, Qt::Key_Right);
+    QVERIFY(TestUtils::waitForImage(&tab));
+    QCOMPARE(tab.currentFilePath(), expected.at(1));
+}
+
+QTEST_MAIN(TestZipArchive)
+#include "tst_ziparchive.moc"